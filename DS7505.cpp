@@ -1,18 +1,32 @@
 #include "DS7505.h"
-#include <Wire.h>
 #include <math.h>
+#if defined(DS7505_HOST)
+#include <DS7505Bus.h>
+#else
+#include "DS7505Transport.h"
+#if defined(DS7505_TWI_QUEUE)
+#include "DS7505Queue.h"
+#else
+#include <Wire.h>
+#endif
+#endif
+
+#if defined(DS7505_STATS)
+#define DS7505_COUNT(addr, field, n) (DS7505::stats(addr).field += (n))
+#else
+#define DS7505_COUNT(addr, field, n) ((void) (addr))
+#endif
 
 // Initialize DS7505
 // a2, a1, a0 are either HIGH (1) or LOW (0) depending
 // on the pin setup.
 void DS7505::init(uint8_t a2, uint8_t a1, uint8_t a0, DS7505::Resolution res)
 {
-  _configByte = res << 5;
-
   // 1001A2A1A0
   _i2cAddr = 0x48 | (a2 & 0x1) << 2 | (a1 & 0x1) << 1 | (a0 & 0x1);
+  _configByte = CONF_UNKNOWN;
 
-  setConfigRegister(_configByte);
+  setConfigRegister(Config().resolution(res).byte());
 }
 
 //set configuration byte
@@ -24,56 +38,140 @@ void DS7505::init(uint8_t a2, uint8_t a1, uint8_t a0, DS7505::Resolution res)
 //bit 2: POL (Thermostat Output Polarity)
 //bit 1: TM (Thermostat Operating Mode)
 //bit 0: SD (Shutdown)
-void DS7505::setConfigRegister(uint8_t configByte)
+//cached: the byte written once the device has it
+uint8_t DS7505::setConfigRegister(uint8_t addr, uint8_t &cached, uint8_t configByte)
 {
-  Wire.beginTransmission(_i2cAddr);
-  Wire.send(P_CONF);
-  Wire.send(_configByte);
-  Wire.endTransmission();
+  uint8_t status;
+
+  configByte &= 0x7F;
+  if ((status = writeRegister(addr, P_CONF, &configByte, 1)) == ST_OK)
+    cached = configByte;
+
+  return status;
 }
 
 //cmdSet:
 //	CMD_RECALL_DATA
 //	CMD_COPY_DATA
 //	CMD_POR
-void DS7505::sendCommand(uint8_t cmdSet)
+//cached: read back after RECALL and POR, CONF_UNKNOWN when it can't be
+uint8_t DS7505::sendCommand(uint8_t addr, uint8_t &cached, uint8_t cmdSet)
 {
-  Wire.beginTransmission(_i2cAddr);
-  Wire.send(cmdSet);
-  Wire.endTransmission();
+  uint8_t status = command(addr, cmdSet);
+
+  //RECALL and POR load the configuration from the EEPROM
+  if (status == ST_OK && cmdSet != CMD_COPY_DATA) {
+    cached = CONF_UNKNOWN;
+    refreshConfig(addr, cached);
+  }
+
+  return status;
 }
 
-//get temperature in Celsius
-float DS7505::getTemp(DS7505::Register regPdef)
+//read back only when not known, NVB is never cached
+uint8_t DS7505::refreshConfig(uint8_t addr, uint8_t &cached)
 {
-  float temp = 0.0;
-  float s = 1.0;
+  uint8_t configByte;
+  uint8_t status;
 
-  Wire.beginTransmission(_i2cAddr);
-  Wire.send(regPdef);
-  Wire.endTransmission();
-  Wire.requestFrom(_i2cAddr, 2u);
+  if (cached != CONF_UNKNOWN)
+    return ST_OK;
 
-  while (!Wire.available()) {  };
+  if ((status = readRegister(addr, P_CONF, &configByte, 1)) == ST_OK)
+    cached = configByte & 0x7F;
 
-  uint8_t h = Wire.receive();
+  return status;
+}
 
-  while (!Wire.available()) {  };
+//a shared host bus runs the command alone, locked through the NV wait
+uint8_t DS7505::command(uint8_t addr, uint8_t cmd)
+{
+#if defined(DS7505_HOST)
+  DS7505Bus *bus = DS7505Bus::current();
 
-  uint8_t l = Wire.receive();
-  Wire.endTransmission();
+  if (bus->shared())
+    return bus->run(commandAccess, addr, cmd, 0, 0, true);
+#endif
 
-  if ((h & 0x80) == 0x80) {
-    s = -1.0;
-    h = h & 0x7f;
-  }
-  else {
-    s = 1.0;
+  return commandLocked(addr, cmd);
+}
+
+//the EEPROM write started by CMD_COPY_DATA takes a while
+uint8_t DS7505::commandLocked(uint8_t addr, uint8_t cmd)
+{
+  uint8_t status = writeRegisterLocked(addr, cmd, 0, 0);
+
+  if (status == ST_OK && cmd == CMD_COPY_DATA)
+    wait(NV_WRITE_MS);
+
+  return status;
+}
+
+//on a host delay() sleeps on the clock of the selected bus
+void DS7505::wait(uint16_t ms)
+{
+  delay(ms);
+}
+
+//one read per conversion period, none of the conversions read twice
+DS7505::Oversample DS7505::oversample(uint8_t k)
+{
+  Resolution res;
+
+  //a conversion period too short would read conversions twice
+  refreshConfig(_i2cAddr, _configByte);
+  res = cachedResolution(_configByte);
+
+  Oversample o = { 0, 0, 0, 0, (uint8_t) (0x80 >> res) };
+  uint16_t n = (uint16_t) 1 << (k < 15 ? k : 15);
+
+  for (uint16_t i = 0; i < n; i++) {
+    uint8_t buf[2];
+
+    wait(conversionTimeMs(res));
+    if (readRegister(_i2cAddr, P_TEMP, buf, 2) != ST_OK)
+      continue;
+
+    int16_t raw = (int16_t) ((uint16_t) buf[0] << 8 | buf[1]);
+    if (o.count == 0)
+      o.first = raw;
+
+    int16_t d = (raw - o.first) / o.step;
+    o.sum += raw;
+    o.squares += (int32_t) d * d;
+    o.count++;
   }
 
-  temp = 0.5 * ((l & 0x80 )>> 7) + 0.25 * ((l & 0x40 )>> 6)+ 0.125 * ((l & 0x20 )>> 5) + 0.0625 * ((l & 0x10 )>> 4) + (float) h;
+  return o;
+}
+
+//rounded half away from zero, 2 * sum would not fit
+int16_t DS7505::Oversample::raw() const
+{
+  if (count == 0)
+    return 0;
+
+  int32_t q = sum / count;
+  int32_t r = sum % count;
+
+  return (int16_t) (q + (2 * r >= count ? 1 : 2 * r <= -(int32_t) count ? -1 : 0));
+}
+
+//sample variance of the codes, in steps
+float DS7505::Oversample::noise() const
+{
+  if (count < 2)
+    return 0;
+
+  float mean = ((float) sum - (float) first * count) / step / count;
+  float var = ((float) squares - mean * mean * count) / (count - 1);
 
-  return temp;
+  return var > 0 ? sqrt(var) * step / 256 : 0;
+}
+
+float DS7505::Oversample::error() const
+{
+  return count ? noise() / sqrt((float) count) : 0;
 }
 
 //set thermostat, temperatures are in Celsius
@@ -81,87 +179,249 @@ float DS7505::getTemp(DS7505::Register regPdef)
 //thyst: hysteresis temperature
 //ft: fault tolerance configuration
 //	FT_1, FT_2, FT_4, FT_6
-void DS7505::setThermostat(float tos, float thyst, FaultTolerance ft)
+DS7505::Thermostat DS7505::setThermostat(uint8_t addr, uint8_t &cached, float tos, float thyst, FaultTolerance ft)
 {
-  if (tos < thyst || tos < -55.0 || thyst < -55.0 || tos > 125.0 || thyst > 125.0) return;
-  float tosr, thystr;
-  uint8_t tos_h, tos_l, thyst_h, thyst_l;
+  Thermostat none = { 0, 0, ST_ERROR };
 
-  tos_l = 0;
-  thyst_l = 0;
+  if (!thermostatInRange(tos, thyst) || (none.status = refreshConfig(addr, cached)) != ST_OK)
+    return none;
 
-  if (tos >= 0) {
-    tos_h = (uint8_t) tos;
-  }
-  else {
-    tos_h = 0x80 & (uint8_t) abs(tos);
-  }
+  //TOS and THYST are compared at the conversion resolution
+  Resolution res = Config(cached).resolution();
+  return setThermostatRaw(addr, cached, encodeTemp(tos, res), encodeTemp(thyst, res), ft);
+}
 
-  tosr = fabs((double) tos) -  (int) abs(tos);
+//set thermostat from raw register values, stop at the first transfer that fails
+//the fault tolerance goes into the configuration as the device has it, never a guess
+DS7505::Thermostat DS7505::setThermostatRaw(uint8_t addr, uint8_t &cached, int16_t tosRaw, int16_t thystRaw, FaultTolerance ft)
+{
+  Thermostat t = { tosRaw, thystRaw, ST_OK };
 
-  if (tosr >= 0.5 ) {
-    tos_l |= 0x80;
-    tosr -= 0.5;
-  }
+  if ((t.status = refreshConfig(addr, cached)) == ST_OK
+      && (t.status = writeRaw(addr, P_TOS, tosRaw)) == ST_OK
+      && (t.status = writeRaw(addr, P_THYST, thystRaw)) == ST_OK)
+    t.status = setConfig(addr, cached, Config(cached).faultTolerance(ft));
 
-  if (tosr >= 0.25) {
-    tos_l |= 0x40;
-    tosr -= 0.25;
-  }
+  return t;
+}
 
-  if (tosr >= 0.125) {
-    tos_l |= 0x20;
-    tosr -= 0.125;
-  }
+#if !defined(DS7505_HOST)
+DS7505Transport *DS7505Transport::_current = 0;
+#endif
 
-  if (tosr >= 0.0625) {
-    tos_l |= 0x10;
+//bus state of each address, each bus but Wire keeps its own
+DS7505::Link &DS7505::link(uint8_t addr)
+{
+#if defined(DS7505_HOST)
+  return DS7505Bus::current()->links[addr & 0x7];
+#elif defined(DS7505_TWI_QUEUE)
+  DS7505Transport *transport = DS7505Transport::current();
+
+  //the interrupt keeps the state of the TWI up to date
+  return transport ? transport->links[addr & 0x7] : DS7505Queue::twi()->links[addr & 0x7];
+#else
+  static Link links[8];
+  DS7505Transport *transport = DS7505Transport::current();
+
+  return transport ? transport->links[addr & 0x7] : links[addr & 0x7];
+#endif
+}
+
+//platform transport: one write transaction (start, address, data, stop)
+static uint8_t busWrite(uint8_t addr, const uint8_t *data, uint8_t n)
+{
+#if defined(DS7505_HOST)
+  return DS7505Bus::current()->submitWrite(addr, data, n);
+#else
+  if (DS7505Transport *transport = DS7505Transport::current())
+    return transport->write(addr, data, n);
+
+#if defined(DS7505_TWI_QUEUE)
+  return DS7505Queue::twi()->write(addr, data, n);
+#else
+  Wire.beginTransmission(addr);
+  for (uint8_t i = 0; i < n; i++)
+    Wire.send(data[i]);
+  return Wire.endTransmission();
+#endif
+#endif
+}
+
+//platform transport: one read transaction (start, address, data, stop)
+static uint8_t busRead(uint8_t addr, uint8_t *data, uint8_t n)
+{
+#if defined(DS7505_HOST)
+  return DS7505Bus::current()->submitRead(addr, data, n);
+#else
+  if (DS7505Transport *transport = DS7505Transport::current())
+    return transport->read(addr, data, n);
+
+#if defined(DS7505_TWI_QUEUE)
+  return DS7505::ST_ERROR; // the queue reads by register, see readRegisterLocked()
+#else
+  //requestFrom() blocks until the transfer is over
+  if (Wire.requestFrom(addr, n) != n)
+    return DS7505::ST_NACK_ADDR;
+
+  for (uint8_t i = 0; i < n; i++)
+    data[i] = Wire.receive();
+
+  return DS7505::ST_OK;
+#endif
+#endif
+}
+
+//count a finished transaction and tell whether it should be retried
+static bool retry(uint8_t addr, uint8_t status, uint8_t &retries)
+{
+  DS7505_COUNT(addr, transactions, 1);
+
+  if (status == DS7505::ST_OK)
+    return false;
+
+  if (status == DS7505::ST_TIMEOUT)
+    DS7505_COUNT(addr, timeouts, 1);
+  else if (status == DS7505::ST_NACK_ADDR || status == DS7505::ST_NACK_DATA)
+    DS7505_COUNT(addr, nacks, 1);
+
+  if (retries == 0)
+    return false;
+
+  retries--;
+  DS7505_COUNT(addr, retries, 1);
+  return true;
+}
+
+#if defined(DS7505_HOST)
+//a shared host bus runs register accesses under its lock, batched
+uint8_t DS7505::writeRegister(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t n)
+{
+  DS7505Bus *bus = DS7505Bus::current();
+
+  if (!bus->shared())
+    return writeRegisterLocked(addr, reg, data, n);
+
+  return bus->run(writeAccess, addr, reg, (uint8_t *) data, n);
+}
+
+uint8_t DS7505::readRegister(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n)
+{
+  DS7505Bus *bus = DS7505Bus::current();
+
+  if (!bus->shared())
+    return readRegisterLocked(addr, reg, data, n);
+
+  return bus->run(readRegisterLocked, addr, reg, data, n);
+}
+#endif
+
+//write n bytes to register reg, n may be 0 to only set the pointer or
+//send a command
+uint8_t DS7505::writeRegisterLocked(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t n)
+{
+  uint8_t buf[4];
+  uint8_t status;
+  uint8_t retries = DS7505_RETRIES;
+
+  buf[0] = reg;
+  for (uint8_t i = 0; i < n; i++)
+    buf[i + 1] = data[i];
+
+  do {
+    status = busWrite(addr, buf, n + 1);
+    DS7505_COUNT(addr, bytesWritten, n + 1);
+  } while (retry(addr, status, retries));
+
+#if defined(DS7505_TWI_QUEUE)
+  //the interrupt tracks the pointers of the TWI devices as the operations run
+  if (!DS7505Transport::current())
+    return status;
+#endif
+
+  //commands leave the pointer in an unknown state
+  link(addr).pointer = (status == ST_OK && reg <= P_TOS) ? reg + 1 : 0;
+
+  return status;
+}
+
+//read n bytes from register reg
+uint8_t DS7505::readRegisterLocked(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n)
+{
+  uint8_t status;
+  uint8_t retries = DS7505_RETRIES;
+
+#if defined(DS7505_TWI_QUEUE)
+  //a single operation, pointed at reg when it runs behind those queued
+  if (!DS7505Transport::current()) {
+    do {
+      status = DS7505Queue::twi()->read(addr, reg, data, n);
+      DS7505_COUNT(addr, bytesRead, n);
+    } while (retry(addr, status, retries));
+
+    return status;
   }
+#endif
 
-  if (thyst >= 0) {
-    thyst_h = (uint8_t) thyst;
+  if (link(addr).pointer == reg + 1) {
+    DS7505_COUNT(addr, pointerSkips, 1);
   }
   else {
-    thyst_h = 0x80 & (uint8_t) abs(thyst);
+    status = writeRegisterLocked(addr, reg, 0, 0);
+    if (status != ST_OK)
+      return status;
   }
 
-  thystr = fabs((double) thyst) - (int) abs(thyst);
+  do {
+    status = busRead(addr, data, n);
+    DS7505_COUNT(addr, bytesRead, n);
+  } while (retry(addr, status, retries));
 
-  if (thystr >= 0.5 ) {
-    thyst_l |= 0x80;
-    thystr -= 0.5;
-  }
+  return status;
+}
 
-  if (thystr >= 0.25) {
-    thyst_l |= 0x40;
-    thystr -= 0.25;
-  }
+//0 when the read fails
+int16_t DS7505::readRaw(uint8_t addr, DS7505::Register reg)
+{
+  int16_t raw = 0;
 
-  if (thystr >= 0.125) {
-    thyst_l |= 0x20;
-    thystr -= 0.125;
-  }
+  readRaw(addr, reg, raw);
 
-  if (thystr >= 0.0625) {
-    thyst_l |= 0x10;
-  }
+  return raw;
+}
+
+//read a temperature register, MSB first
+uint8_t DS7505::readRaw(uint8_t addr, DS7505::Register reg, int16_t &raw)
+{
+  uint8_t buf[2];
+  uint8_t status;
 
-  Wire.beginTransmission(_i2cAddr);
-  Wire.send(P_TOS);
-  Wire.send(tos_h);
-  Wire.send(tos_l);
-  Wire.endTransmission();
+#if defined(DS7505_STATS)
+  unsigned long start = micros();
+#endif
 
-  Wire.beginTransmission(_i2cAddr);
-  Wire.send(P_THYST);
-  Wire.send(thyst_h);
-  Wire.send(thyst_l);
-  Wire.endTransmission();
+  status = readRegister(addr, reg, buf, 2);
 
-  //clear F1F0 then set F1F0 using ft
-  _configByte &= 0xE7;
-  _configByte |= ft << 3;
+#if defined(DS7505_STATS)
+  unsigned long us = micros() - start;
+  uint8_t bucket = 0;
 
-  setConfigRegister(_configByte);
+  while (us > 1 && bucket < LATENCY_BUCKETS - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  link(addr).stats.latency[bucket]++;
+#endif
+
+  if (status == ST_OK)
+    raw = (int16_t) ((uint16_t) buf[0] << 8 | buf[1]);
+
+  return status;
 }
 
+//write a temperature register, MSB first
+uint8_t DS7505::writeRaw(uint8_t addr, DS7505::Register reg, int16_t raw)
+{
+  uint8_t buf[2] = { (uint8_t) (raw >> 8), (uint8_t) raw };
+
+  return writeRegister(addr, reg, buf, 2);
+}
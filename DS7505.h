@@ -8,11 +8,36 @@
   || defined(BOARD_maple_mini) \
   || defined(BOARD_maple_native)
 #define DS7505_MAPLE
+#else
+#define DS7505_HOST // bus access through DS7505Bus, see extras/host
+#endif
+
+// Define (here or on the command line) to collect per sensor bus
+// statistics, see DS7505::stats(). Costs nothing when left undefined.
+//#define DS7505_STATS
+
+// Define (here or on the command line) to run the TWI of AVR boards from
+// its interrupt through DS7505Queue instead of Wire, see DS7505Queue.h.
+// Sketches must then leave Wire out. Ignored on other platforms.
+//#define DS7505_TWI_QUEUE
+#if defined(DS7505_TWI_QUEUE) && !defined(DS7505_ARDUINO)
+#undef DS7505_TWI_QUEUE
+#endif
+
+// Number of times a NACKed transaction is retried
+#ifndef DS7505_RETRIES
+#define DS7505_RETRIES 0
+#endif
+
+#if __cplusplus >= 201103L
+#define DS7505_CONSTEXPR constexpr
+#else
+#define DS7505_CONSTEXPR
 #endif
 
 #include <inttypes.h>
 #if defined(ARDUINO)
-#include <WProgram.h> // Needed for abs()
+#include <WProgram.h> // Needed for micros() and delay()
 #endif
 
 /*! \mainpage DS7505 Library
@@ -31,12 +56,12 @@
  *  ds7505.init(0, 0, 0, DS7505::RES_12);
  *
  *  // Set the thermostat at 32.45 (Celsius) with a hysteresis of 30.14 degree
- *  ds7505.setThermostatC(32.45f, 30.14f, DS7505::FT_6);
+ *  DS7505::Thermostat t = ds7505.setThermostatC(32.45f, 30.14f, DS7505::FT_6);
  *
- *  // The temperatures read back will be slightly off depending on the resolution
+ *  // The temperatures programmed are slightly off depending on the resolution
  *  // settings
- *  Serial.println(ds7505.getTempC(DS7505::P_TOS));
- *  Serial.println(ds7505.getTempC(DS7505::P_THYST));
+ *  Serial.println(t.tosC());
+ *  Serial.println(t.thystC());
  *
  *  // Make the settings permanent (write to NV memory)
  *  ds7505.sendCommand(DS7505::CMD_COPY_DATA);
@@ -76,6 +101,58 @@ public:
     FT_6 = 0x3, /*!< fault tolerance consecutive out of limits 6 */
   };
 
+  //! Thermostat output (O.S.) polarity
+  enum Polarity {
+    POL_ACTIVE_LOW = 0x0, /*!< O.S. is active low (power-up default) */
+    POL_ACTIVE_HIGH = 0x1, /*!< O.S. is active high */
+  };
+
+  //! Thermostat operating mode
+  enum Mode {
+    MODE_COMPARATOR = 0x0, /*!< O.S. follows TOS/THYST (power-up default) */
+    MODE_INTERRUPT = 0x1, /*!< O.S. latches until any register is read */
+  };
+
+  //! Configuration register value
+  /*!
+   * Builds the [ NVB R1 R0 F1 F0 POL TM SD ] byte from typed fields, NVB is
+   * read-only and always left cleared.
+   * \code
+   *  ds7505.setConfig(DS7505::Config()
+   *      .resolution(DS7505::RES_12)
+   *      .faultTolerance(DS7505::FT_6)
+   *      .mode(DS7505::MODE_INTERRUPT));
+   * \endcode
+   */
+  class Config
+  {
+  public:
+    DS7505_CONSTEXPR Config(uint8_t configByte = 0) : _configByte(configByte & 0x7F) {}
+
+    //! Conversion resolution (R1 R0)
+    DS7505_CONSTEXPR Config resolution(Resolution res) const { return Config((_configByte & 0x9F) | res << 5); }
+    //! Thermostat fault tolerance (F1 F0)
+    DS7505_CONSTEXPR Config faultTolerance(FaultTolerance ft) const { return Config((_configByte & 0xE7) | ft << 3); }
+    //! Thermostat output polarity (POL)
+    DS7505_CONSTEXPR Config polarity(Polarity pol) const { return Config((_configByte & 0xFB) | pol << 2); }
+    //! Thermostat operating mode (TM)
+    DS7505_CONSTEXPR Config mode(Mode tm) const { return Config((_configByte & 0xFD) | tm << 1); }
+    //! Shutdown (SD)
+    DS7505_CONSTEXPR Config shutdown(bool sd) const { return Config((_configByte & 0xFE) | sd); }
+
+    DS7505_CONSTEXPR Resolution resolution() const { return (Resolution) (_configByte >> 5 & 0x3); }
+    DS7505_CONSTEXPR FaultTolerance faultTolerance() const { return (FaultTolerance) (_configByte >> 3 & 0x3); }
+    DS7505_CONSTEXPR Polarity polarity() const { return (Polarity) (_configByte >> 2 & 0x1); }
+    DS7505_CONSTEXPR Mode mode() const { return (Mode) (_configByte >> 1 & 0x1); }
+    DS7505_CONSTEXPR bool shutdown() const { return _configByte & 0x1; }
+
+    //! The raw configuration byte
+    DS7505_CONSTEXPR uint8_t byte() const { return _configByte; }
+
+  private:
+    uint8_t _configByte;
+  };
+
   //! Registers Pointer Definition
   enum Register {
     P_TEMP = 0x0, // temperature
@@ -92,14 +169,111 @@ public:
     CMD_POR = 0x54,
   };
 
+  //! Transaction status, the values match Wire's endTransmission()
+  enum Status {
+    ST_OK = 0x0, /*!< success */
+    ST_TOO_LONG = 0x1, /*!< data too long for the transmit buffer */
+    ST_NACK_ADDR = 0x2, /*!< address NACKed */
+    ST_NACK_DATA = 0x3, /*!< data NACKed */
+    ST_ERROR = 0x4, /*!< other bus error */
+    ST_TIMEOUT = 0x5, /*!< bus timeout (host, bit-banged and TWI queue transports only) */
+  };
+
+#if defined(DS7505_STATS)
+  //! Number of getTemp() latency histogram buckets
+  static const uint8_t LATENCY_BUCKETS = 16;
+
+  //! Bus statistics of one sensor
+  struct Stats {
+    uint32_t transactions; /*!< bus transactions, retries included */
+    uint32_t bytesWritten; /*!< bytes written, pointers included */
+    uint32_t bytesRead; /*!< bytes read */
+    uint32_t pointerSkips; /*!< pointer writes skipped, the device already pointed at the register */
+    uint16_t retries; /*!< transactions retried */
+    uint16_t timeouts; /*!< transactions that timed out */
+    uint16_t nacks; /*!< transactions NACKed */
+    //! Register read latency, bucket i counts reads that took [2^i, 2^(i+1)) us
+    uint16_t latency[LATENCY_BUCKETS];
+  };
+
+  //! Bus statistics of the sensor at the specified address
+  /*!
+   * On the host the statistics of the bus selected for the calling thread
+   * are returned.
+   * \param addr The I2C address
+   */
+  static Stats &stats(uint8_t addr) { return link(addr).stats; }
+#endif
+
+  //! Bus state of one device, kept per address by the transport layer
+  struct Link {
+    uint8_t pointer; /*!< register pointer + 1, 0 when unknown */
+#if defined(DS7505_STATS)
+    Stats stats;
+#endif
+  };
+
+  //! The thermostat as programmed by setThermostatRaw() and the like
+  struct Thermostat {
+    int16_t tos; /*!< raw trip temperature written */
+    int16_t thyst; /*!< raw hysteresis temperature written */
+    uint8_t status; /*!< a \ref Status, ST_ERROR for temperatures out of range (nothing written) */
+
+    //! The trip temperature programmed in Celsius, quantised at the resolution
+    float tosC() const { return decodeTemp(tos); }
+
+    //! The hysteresis temperature programmed in Celsius, quantised at the resolution
+    float thystC() const { return decodeTemp(thyst); }
+  };
+
+  //! Result of oversample()
+  struct Oversample {
+    int32_t sum; /*!< sum of the raw codes */
+    uint32_t squares; /*!< sum of the squared deviations from the first code, in steps */
+    int16_t first; /*!< first raw code */
+    uint16_t count; /*!< conversions read */
+    uint8_t step; /*!< raw code of one step at the resolution read */
+
+    //! The mean as a raw code, decodeTemp() scale, rounded to 1/256 degree
+    int16_t raw() const;
+
+    //! The mean in Celsius
+    float celsius() const { return count ? sum / 256.0 / count : 0; }
+
+    //! Standard deviation of one conversion in Celsius, the noise estimate
+    float noise() const;
+
+    //! Standard error of the mean in Celsius, noise() / sqrt(count)
+    float error() const;
+  };
+
   //! Default constructor.
   DS7505() {};
 
+  //! Get the raw value of the specified register
+  /*!
+   * \param regPdef
+   *   P_TEMP: get the temperature register
+   *   P_THYST: get the hysteresis register
+   *   P_TOS: get the trip register
+   * \return The register as a left justified two's complement value,
+   *   see decodeTemp()
+   */
+  int16_t getRaw(Register regPdef = P_TEMP) { return readRaw(_i2cAddr, regPdef); }
+
+  //! Get the raw value of the specified register, and whether it was read
+  /*!
+   * \param raw Where to store the register, untouched unless ST_OK
+   * \param regPdef The register, see getRaw()
+   * \return A \ref Status
+   */
+  uint8_t getRaw(int16_t &raw, Register regPdef = P_TEMP) { return readRaw(_i2cAddr, regPdef, raw); }
+
   //! Get the current temperature in Celsius. */
   float getTempC() { return getTemp(P_TEMP); }
 
   //! Get the current temperature in Fahrenheit */
-  float getTempF() { return 9.0/5.0 * getTemp(P_TEMP) + 32.0; }
+  float getTempF() { return toFahrenheit(getTemp(P_TEMP)); }
 
   //! Get the temperature specified by \ref refPdef in Celsius */
   /*!
@@ -117,51 +291,141 @@ public:
    *   P_THYST: get hysteresis temperature
    *   P_OS: get trip temperature
    */
-  float getTempF(Register regPdef) { return 9.0/5.0 * getTemp(regPdef) + 32.0;}
+  float getTempF(Register regPdef) { return toFahrenheit(getTemp(regPdef)); }
 
   //! Sets the thermostat trip temperature in Celsius */
   /*!
    * Hysteresis is set to be 5 degree below trip temperature
    * \param t The temperature
+   * \return The thermostat programmed
    */
-  void setThermostatC(float t) { setThermostatC(t, t - 5.0); }
+  Thermostat setThermostatC(float t) { return setThermostatC(t, t - 5.0); }
 
   //! Sets the thermostat temperature in Fahrenheit
   /*!
    * Hysteresis is set to be 5 degree below trip temperature
    * \param t The temperature
+   * \return The thermostat programmed
    */
-  void setThermostatF(float t) { setThermostatF(t, t - 5.0); }
+  Thermostat setThermostatF(float t) { return setThermostatF(t, t - 5.0); }
 
   //! Sets the thermostat temperature in Celsius
   /*!
    * \param tos trip temperature
    * \param thyst hysteresis temperature
+   * \return The thermostat programmed
    */
-  void setThermostatC(float tos, float thyst) { setThermostatC(tos, thyst, FT_1); }
+  Thermostat setThermostatC(float tos, float thyst) { return setThermostatC(tos, thyst, FT_1); }
 
   //! Sets the thermostat temperature in Fahrenheit
   /*!
    * \param tos trip temperature
    * \param thyst hysteresis temperature
+   * \return The thermostat programmed
    */
-  void setThermostatF(float tos, float thyst) { setThermostatF(tos, thyst, FT_1); }
+  Thermostat setThermostatF(float tos, float thyst) { return setThermostatF(tos, thyst, FT_1); }
 
   //! Sets the thermostat temperature in Celsius
   /*!
    * \param tos trip temperature
    * \param thyst hysteresis temperature
    * \param ft fault tolerance (consecutive out-of-limits conversions before tripping)
+   * \return The thermostat programmed, the temperatures rounded to the
+   *   resolution, in Celsius with Thermostat::tosC() and thystC()
    */
-  void setThermostatC(float tos, float thyst, FaultTolerance ft) { setThermostat(tos, thyst, ft); }
+  Thermostat setThermostatC(float tos, float thyst, FaultTolerance ft) { return setThermostat(tos, thyst, ft); }
 
   //! Sets the thermostat temperature in Fahrenheit
   /*!
    * \param tos trip temperature
    * \param thyst hysteresis temperature
    * \param ft fault tolerance (consecutive out-of-limits conversions before tripping)
+   * \return The thermostat programmed, in Celsius with Thermostat::tosC()
+   *   and thystC()
+   */
+  Thermostat setThermostatF(float tos, float thyst, FaultTolerance ft) { return setThermostat(toCelsius(tos), toCelsius(thyst), ft); }
+
+  //! Encodes a temperature in Celsius to the TOS/THYST register format
+  /*!
+   * The temperature is scaled to steps of the given resolution (0.5, 0.25,
+   * 0.125 or 0.0625 degree), rounded once to the nearest step and packed as
+   * a left justified two's complement value:
+   *   [ S 2^6 2^5 2^4 2^3 2^2 2^1 2^0 | 2^-1 2^-2 2^-3 2^-4 0 0 0 0 ]
+   * \param t The temperature in Celsius (-55 to 125)
+   * \param res The resolution the thermostat compares at
+   * \return The raw register value, decodeTemp() of it is the exact
+   *   temperature that gets programmed
+   */
+  static DS7505_CONSTEXPR int16_t encodeTemp(float t, Resolution res)
+  {
+    // 2, 4, 8 or 16 steps per degree, rounded half away from zero, the
+    // unused LSBs of the 16 bit register are left cleared
+    return (int16_t) ((uint16_t) (int16_t) (t * (2 << res) + (t < 0 ? -0.5f : 0.5f)) << (7 - res));
+  }
+
+  //! Encodes a temperature in hundredths of a degree Celsius to the TOS/THYST register format
+  /*!
+   * Integer only version of encodeTemp(), usable in constant expressions.
+   * \param centi The temperature in 1/100 degree Celsius (-5500 to 12500)
+   * \param res The resolution the thermostat compares at
+   */
+  static DS7505_CONSTEXPR int16_t encodeCenti(int16_t centi, Resolution res)
+  {
+    return (int16_t) ((uint16_t) (int16_t) (((int32_t) centi * (2 << res) + (centi < 0 ? -50 : 50)) / 100) << (7 - res));
+  }
+
+  //! Decodes a raw register value to Celsius
+  /*!
+   * \param raw The raw (MSB first) value of the P_TEMP, P_THYST or P_TOS register
+   */
+  static float decodeTemp(int16_t raw) { return raw / 256.0; }
+
+  //! Converts Celsius to Fahrenheit
+  static float toFahrenheit(float c) { return 9.0/5.0 * c + 32.0; }
+
+  //! Converts Fahrenheit to Celsius
+  static float toCelsius(float f) { return (f - 32.0) * 5.0 / 9.0; }
+
+  //! Maximum conversion time in milliseconds at the given resolution
+  /*!
+   * 25ms at 9 bits, doubling with each extra bit up to 200ms at 12 bits.
    */
-  void setThermostatF(float tos, float thyst, FaultTolerance ft) { setThermostat((tos - 32.0) * 5.0 / 9.0, (thyst - 32.0) * 5.0 / 9.0, ft); }
+  static DS7505_CONSTEXPR uint8_t conversionTimeMs(Resolution res) { return 25 << res; }
+
+  //! Time in milliseconds the device is left alone after CMD_COPY_DATA (EEPROM write)
+  static const uint8_t NV_WRITE_MS = 50;
+
+  //! Sets the thermostat from raw register values
+  /*!
+   * \param tosRaw trip temperature, as returned by encodeTemp()
+   * \param thystRaw hysteresis temperature, as returned by encodeTemp()
+   * \param ft fault tolerance (consecutive out-of-limits conversions before tripping)
+   * The fault tolerance is written into the configuration as last known,
+   * read back first when it is not.
+   * \return The codes written and the status of the first transfer that failed
+   */
+  Thermostat setThermostatRaw(int16_t tosRaw, int16_t thystRaw, FaultTolerance ft) { return setThermostatRaw(_i2cAddr, _configByte, tosRaw, thystRaw, ft); }
+
+#if __cplusplus >= 201103L
+  //! Thermostat settings encoded at compile time
+  /*!
+   * Temperatures are in hundredths of a degree Celsius, out of range or
+   * inverted thresholds fail to compile.
+   * \code
+   *  ds7505.setThermostat(DS7505::Thresholds<3245, 3014, DS7505::FT_6>());
+   * \endcode
+   */
+  template <int16_t TosCenti, int16_t ThystCenti, FaultTolerance FT = FT_1, Resolution RES = RES_12>
+  struct Thresholds;
+
+  //! Sets the thermostat from compile time encoded settings
+  template <int16_t TosCenti, int16_t ThystCenti, FaultTolerance FT, Resolution RES>
+  Thermostat setThermostat(Thresholds<TosCenti, ThystCenti, FT, RES>)
+  {
+    return setThermostatRaw(Thresholds<TosCenti, ThystCenti, FT, RES>::tos,
+                     Thresholds<TosCenti, ThystCenti, FT, RES>::thyst, FT);
+  }
+#endif
 
   //! Sets the configuration register
   /*!
@@ -175,8 +439,26 @@ public:
    *   TM: Thermostat Operating Mode
    *   SD: Shutdown
    *   [ NVB R1 R0 F1 F0 POL TM SD] (see DS7505 data-sheet)
+   * \return A DS7505::Status, config() is unchanged unless ST_OK
+   */
+  uint8_t setConfigRegister(uint8_t configByte) { return setConfigRegister(_i2cAddr, _configByte, configByte); }
+
+  //! Sets the configuration register if it differs from the current one
+  /*!
+   * The driver keeps the last written configuration, so changing a field
+   * costs at most one register write and never a read back.
+   * \param config The new configuration
+   * \return A DS7505::Status, ST_OK when there was nothing to write
+   */
+  uint8_t setConfig(Config config) { return setConfig(_i2cAddr, _configByte, config); }
+
+  //! The configuration of the device as last written or read back
+  /*!
+   * Every field reads 0 when it is unknown: init() failed, or the read
+   * back after CMD_RECALL_DATA or CMD_POR did. setConfig() then writes;
+   * the setThermostat functions and oversample() read it back first.
    */
-  void setConfigRegister(uint8_t configByte);
+  Config config() const { return Config(_configByte); }
 
   //! Send a command
   /*!
@@ -184,8 +466,35 @@ public:
    * 	CMD_RECALL_DATA
    * 	CMD_COPY_DATA
    * 	CMD_POR
+   *
+   * CMD_COPY_DATA returns once the EEPROM is written, see \ref NV_WRITE_MS.
+   * CMD_RECALL_DATA and CMD_POR reload the configuration from the EEPROM,
+   * config() reads it back.
+   * \return A DS7505::Status
    */
-  void sendCommand(uint8_t cmdSet);
+  uint8_t sendCommand(uint8_t cmdSet) { return sendCommand(_i2cAddr, _configByte, cmdSet); }
+
+  //! Waits for a conversion at the configured resolution to complete
+  /*!
+   * With delay() on a board, with the clock of the bus on a host (see
+   * DS7505Clock) where it may be virtual. The 12 bit time when the
+   * configuration is unknown.
+   */
+  void waitConversion() { wait(conversionTimeMs(cachedResolution(_configByte))); }
+
+  //! Averages 2^k conversions, for a resolution beyond the 12 bits
+  /*!
+   * Reads the temperature once per conversion period, starting one period
+   * ahead so that every code read is a fresh conversion, and sums the
+   * codes in 32 bits. The mean gains k/2 bits when the noise of the sensor
+   * dithers it over a step or more: raw() keeps them up to the 1/256
+   * degree of the register format, celsius() beyond. noise() estimates the
+   * noise from the spread of the codes. Takes 2^k conversion periods, 3.2
+   * seconds for k = 4 at 12 bits.
+   * \param k log2 of the conversions, 15 at most
+   * \return The sum of the codes read, failed reads are left out
+   */
+  Oversample oversample(uint8_t k);
 
   //! initialization
   /*!
@@ -197,9 +506,42 @@ public:
   void init(uint8_t a2, uint8_t a1, uint8_t a0, Resolution res);
 
 private:
+  template <uint8_t A2, uint8_t A1, uint8_t A0, Resolution RES> friend class DS7505Fixed;
+  friend class DS7505Array;
+  friend class DS7505Queue;
+  friend class DS7505Scheduler;
+  friend class DS7505Watch;
+
   uint8_t _i2cAddr;
   uint8_t _configByte;
 
+  //! _configByte of a configuration not known, NVB is never cached
+  static const uint8_t CONF_UNKNOWN = 0x80;
+
+  //! The resolution of a cached configuration, RES_12 (the longest conversion) when unknown
+  static Resolution cachedResolution(uint8_t cached) { return cached == CONF_UNKNOWN ? RES_12 : Config(cached).resolution(); }
+
+  //! Reads the configuration of the device at \ref addr into \ref cached when it is unknown
+  static uint8_t refreshConfig(uint8_t addr, uint8_t &cached);
+
+  //! setConfigRegister() of the device at \ref addr, its configuration cached in \ref cached
+  static uint8_t setConfigRegister(uint8_t addr, uint8_t &cached, uint8_t configByte);
+
+  //! setConfig() of the device at \ref addr, its configuration cached in \ref cached
+  static uint8_t setConfig(uint8_t addr, uint8_t &cached, Config config)
+  {
+    return config.byte() != cached ? setConfigRegister(addr, cached, config.byte()) : (uint8_t) ST_OK;
+  }
+
+  //! sendCommand() to the device at \ref addr, its configuration cached in \ref cached
+  static uint8_t sendCommand(uint8_t addr, uint8_t &cached, uint8_t cmdSet);
+
+  //! setThermostatRaw() of the device at \ref addr, its configuration cached in \ref cached
+  static Thermostat setThermostatRaw(uint8_t addr, uint8_t &cached, int16_t tosRaw, int16_t thystRaw, FaultTolerance ft);
+
+  //! setThermostat() of the device at \ref addr, its configuration cached in \ref cached
+  static Thermostat setThermostat(uint8_t addr, uint8_t &cached, float tos, float thyst, FaultTolerance ft);
+
   //! Gets the temperature in Celsius from the specified register
   /*!
    * \param regPdef
@@ -207,15 +549,117 @@ private:
    *   P_THYST: get hysteresis temperature
    *   P_OS: get trip temperature
    */
-  float getTemp(Register regPdef);
+  float getTemp(Register regPdef) { return decodeTemp(getRaw(regPdef)); }
+
+  //! Whether the thermostat temperatures are valid for setThermostat()
+  static bool thermostatInRange(float tos, float thyst)
+  {
+    return tos >= thyst && thyst >= -55.0 && tos <= 125.0;
+  }
+
+  //! The bus state of the device at the specified address
+  static Link &link(uint8_t addr);
+
+  //! delay() on a board, the clock of the bus on a host
+  static void wait(uint16_t ms);
+
+  //! Sends a command, waiting for the NV copy to complete
+  /*!
+   * A shared host bus stays locked meanwhile and the command is never
+   * batched, see DS7505Bus::run().
+   */
+  static uint8_t command(uint8_t addr, uint8_t cmd);
+
+  //! command() once the bus is locked
+  static uint8_t commandLocked(uint8_t addr, uint8_t cmd);
+
+  //! Writes \ref n bytes to a register
+  /*!
+   * \param addr The I2C address
+   * \param reg The register pointer or command
+   * \param data The bytes to write after the pointer (3 at most)
+   * \param n The number of bytes
+   * \return A \ref Status
+   */
+#if defined(DS7505_HOST)
+  static uint8_t writeRegister(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t n);
+#else
+  static uint8_t writeRegister(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t n) { return writeRegisterLocked(addr, reg, data, n); }
+#endif
+
+  //! Reads \ref n bytes from a register
+  /*!
+   * The pointer write is skipped when the device already points at \ref reg.
+   * \param addr The I2C address
+   * \param reg The register pointer
+   * \param data Where to store the bytes read
+   * \param n The number of bytes
+   * \return A \ref Status
+   */
+#if defined(DS7505_HOST)
+  static uint8_t readRegister(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n);
+#else
+  static uint8_t readRegister(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n) { return readRegisterLocked(addr, reg, data, n); }
+#endif
+
+  //! writeRegister() once the bus is locked, see DS7505Bus::run()
+  /*!
+   * A board has a single thread, nothing to lock: writeRegister() only
+   * forwards to it.
+   */
+  static uint8_t writeRegisterLocked(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t n);
+
+  //! readRegister() once the bus is locked, see DS7505Bus::run()
+  static uint8_t readRegisterLocked(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n);
+
+#if defined(DS7505_HOST)
+  //! writeRegisterLocked() with the signature of DS7505Bus::Access
+  static uint8_t writeAccess(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n)
+  {
+    return writeRegisterLocked(addr, reg, data, n);
+  }
+
+  //! commandLocked() with the signature of DS7505Bus::Access
+  static uint8_t commandAccess(uint8_t addr, uint8_t reg, uint8_t *, uint8_t)
+  {
+    return commandLocked(addr, reg);
+  }
+#endif
+
+  //! Reads a 16 bit temperature register, 0 when it fails
+  static int16_t readRaw(uint8_t addr, Register reg);
+
+  //! Reads a 16 bit temperature register into \ref raw, untouched unless ST_OK
+  static uint8_t readRaw(uint8_t addr, Register reg, int16_t &raw);
+
+  //! Writes a 16 bit temperature register
+  static uint8_t writeRaw(uint8_t addr, Register reg, int16_t raw);
 
   //! Sets the thermostat temperature in Celsius
   /*!
    * \param tos trip temperature
    * \param thyst hysteresis temperature
    * \param ft fault tolerance (consecutive out-of-limits conversions before tripping)
+   * \return The thermostat programmed
    */
-  void setThermostat(float tos, float thyst, FaultTolerance ft);
+  Thermostat setThermostat(float tos, float thyst, FaultTolerance ft)
+  {
+    return setThermostat(_i2cAddr, _configByte, tos, thyst, ft);
+  }
 };
 
+#if __cplusplus >= 201103L
+template <int16_t TosCenti, int16_t ThystCenti, DS7505::FaultTolerance FT, DS7505::Resolution RES>
+struct DS7505::Thresholds
+{
+  static_assert(TosCenti >= -5500 && TosCenti <= 12500, "TOS must be within -55..125 degree");
+  static_assert(ThystCenti >= -5500 && ThystCenti <= 12500, "THYST must be within -55..125 degree");
+  static_assert(TosCenti >= ThystCenti, "TOS must not be below THYST");
+
+  static constexpr int16_t tos = DS7505::encodeCenti(TosCenti, RES);
+  static constexpr int16_t thyst = DS7505::encodeCenti(ThystCenti, RES);
+  static constexpr FaultTolerance ft = FT;
+};
+#endif
+
 #endif
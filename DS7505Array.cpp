@@ -0,0 +1,38 @@
+#include "DS7505Array.h"
+
+//configure every sensor in mask, keep those that acknowledged
+uint8_t DS7505Array::init(uint8_t mask, DS7505::Resolution res)
+{
+  _configByte = DS7505::Config().resolution(res).byte();
+  _mask = 0;
+
+  for (uint8_t i = 0; i < 8; i++) {
+    if (!(mask & 1 << i))
+      continue;
+
+    if (DS7505::writeRegister(0x48 | i, DS7505::P_CONF, &_configByte, 1) == DS7505::ST_OK)
+      _mask |= 1 << i;
+  }
+
+  return _mask;
+}
+
+//read P_TEMP of the sensors of mask in the array
+uint8_t DS7505Array::sweep(int16_t raw[8], uint8_t mask)
+{
+  uint8_t read = 0;
+  uint8_t buf[2];
+
+  mask &= _mask;
+  for (uint8_t i = 0; i < 8; i++) {
+    if (!(mask & 1 << i))
+      continue;
+
+    if (DS7505::readRegister(0x48 | i, DS7505::P_TEMP, buf, 2) == DS7505::ST_OK) {
+      raw[i] = (int16_t) ((uint16_t) buf[0] << 8 | buf[1]);
+      read |= 1 << i;
+    }
+  }
+
+  return read;
+}
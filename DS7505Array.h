@@ -0,0 +1,77 @@
+#ifndef DS7505_ARRAY_H
+#define DS7505_ARRAY_H
+
+#include "DS7505.h"
+
+//! Up to eight DS7505 sharing a bus, read together in sweeps
+/*!
+ * Sensors are selected by a mask, bit i standing for the sensor wired to
+ * address 1001A2A1A0 = 0x48 | i. All of them run at the same resolution so
+ * one sweep per conversion period reads every sensor once; after the
+ * first sweep each sensor costs a single 2 byte read.
+ *
+ * \code
+ *
+ *  DS7505Array sensors;
+ *  int16_t raw[8];
+ *
+ *  Wire.begin();
+ *  // sensors at 0 0 0 and 0 0 1
+ *  sensors.init(0x03, DS7505::RES_12);
+ *
+ *  sensors.waitConversion();
+ *  uint8_t read = sensors.sweep(raw);
+ *  if (read & 0x02)
+ *    Serial.println(DS7505::decodeTemp(raw[1]));
+ *
+ * \endcode
+ */
+class DS7505Array
+{
+
+public:
+
+  //! Default constructor.
+  DS7505Array() : _mask(0), _configByte(0) {};
+
+  //! initialization
+  /*!
+   * \param mask The sensors on the bus, bit i for address 0x48 | i
+   * \param res The temperature resolution of every sensor
+   * \return The sensors that acknowledged, the others are left out
+   */
+  uint8_t init(uint8_t mask, DS7505::Resolution res);
+
+  //! Reads the temperature of every sensor
+  /*!
+   * \param raw Where to store the raw codes, raw[i] for address 0x48 | i
+   * \return The sensors read successfully, the other entries are untouched
+   */
+  uint8_t sweep(int16_t raw[8]) { return sweep(raw, _mask); }
+
+  //! Reads the temperature of the sensors in \ref mask only
+  /*!
+   * \param raw Where to store the raw codes, raw[i] for address 0x48 | i
+   * \param mask The sensors to read, those outside the array are skipped
+   * \return The sensors read successfully, the other entries are untouched
+   */
+  uint8_t sweep(int16_t raw[8], uint8_t mask);
+
+  //! The sensors in the array
+  uint8_t mask() const { return _mask; }
+
+  //! The resolution of the sensors
+  DS7505::Resolution resolution() const { return DS7505::Config(_configByte).resolution(); }
+
+  //! Maximum conversion time in milliseconds, the useful sweep period
+  uint8_t conversionTimeMs() const { return DS7505::conversionTimeMs(resolution()); }
+
+  //! Waits for a conversion to complete, see DS7505::waitConversion()
+  void waitConversion() const { DS7505::wait(conversionTimeMs()); }
+
+private:
+  uint8_t _mask;
+  uint8_t _configByte;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef DS7505_DEADBAND_H
+#define DS7505_DEADBAND_H
+
+#include "DS7505.h"
+
+//! Change-only reporting of up to eight sensors
+/*!
+ * A sample passes when its raw code moved beyond the deadband from the
+ * last one reported for its sensor, or when the heartbeat expired since
+ * that report; the others are suppressed and counted. Each sample costs a
+ * compare or two, each sensor 6 bytes.
+ *
+ * \code
+ *
+ *  // a change of more than 0.125 C, or once a minute
+ *  DS7505Deadband<1> band(DS7505::encodeTemp(0.125f, DS7505::RES_12), 60);
+ *
+ *  int16_t raw = ds7505.getRaw();
+ *  if (band.pass(0, raw, millis() / 1000))
+ *    Serial.println(DS7505::decodeTemp(raw));
+ *
+ *  // or behind a sweep
+ *  DS7505Deadband<8> bands(DS7505::encodeTemp(0.125f, DS7505::RES_12), 60);
+ *
+ *  uint8_t report = bands.filter(sensors.sweep(raw), raw, millis() / 1000);
+ *
+ * \endcode
+ *
+ * Times are in any unit the heartbeat is given in, they only need to fit
+ * 16 bits between two reports of a sensor.
+ *
+ * \tparam N The number of sensors, 8 at most
+ */
+template <uint8_t N = 8>
+class DS7505Deadband
+{
+
+public:
+
+  //! State of one sensor
+  struct Channel {
+    int16_t last; /*!< raw code last reported */
+    uint16_t sent; /*!< time of the last report */
+    uint16_t suppressed; /*!< samples suppressed since, saturating */
+  };
+
+  //! Builds the filter, every sensor reports its first sample
+  /*!
+   * \param deadband The raw change suppressed, 0 to report every change
+   * \param heartbeat The time after which a sample is reported anyway, 0 for never
+   */
+  DS7505Deadband(int16_t deadband = 0, uint16_t heartbeat = 0)
+    : deadband(deadband), heartbeat(heartbeat), reported(0), suppressed(0), _primed(0)
+  {
+    for (uint8_t i = 0; i < N; i++) {
+      Channel c = { 0, 0, 0 };
+      _channels[i] = c;
+    }
+  }
+
+  //! Raw change suppressed
+  int16_t deadband;
+
+  //! Time after which a sample is reported anyway, 0 for never
+  uint16_t heartbeat;
+
+  //! Samples passed, all sensors together
+  uint32_t reported;
+
+  //! Samples suppressed, all sensors together
+  uint32_t suppressed;
+
+  //! Whether to report a sample
+  /*!
+   * \param i The sensor
+   * \param raw The raw code
+   * \param t The time of the sample
+   */
+  bool pass(uint8_t i, int16_t raw, uint16_t t)
+  {
+    Channel &c = _channels[i];
+    int32_t moved = (int32_t) raw - c.last;
+
+    if ((_primed & 1 << i) && moved <= deadband && moved >= -deadband
+        && (heartbeat == 0 || (uint16_t) (t - c.sent) < heartbeat)) {
+      if (c.suppressed != 0xFFFF) c.suppressed++;
+      suppressed++;
+      return false;
+    }
+
+    _primed |= 1 << i;
+    c.last = raw;
+    c.sent = t;
+    c.suppressed = 0;
+    reported++;
+    return true;
+  }
+
+  //! Filters the result of a sweep, see DS7505Array::sweep()
+  /*!
+   * \param read The sensors read
+   * \param raw Their raw codes
+   * \param t The time of the sweep
+   * \return The sensors to report
+   */
+  uint8_t filter(uint8_t read, const int16_t raw[N], uint16_t t)
+  {
+    uint8_t report = 0;
+
+    for (uint8_t i = 0; i < N; i++)
+      if (read & 1 << i && pass(i, raw[i], t))
+        report |= 1 << i;
+
+    return report;
+  }
+
+  //! The state of sensor \ref i
+  const Channel &channel(uint8_t i) const { return _channels[i]; }
+
+  //! Reports the next sample of sensor \ref i whatever its value
+  void reset(uint8_t i) { _primed &= ~(1 << i); }
+
+private:
+  Channel _channels[N];
+  uint8_t _primed; // sensors that reported once
+};
+
+#endif
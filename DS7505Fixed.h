@@ -0,0 +1,130 @@
+#ifndef DS7505_FIXED_H
+#define DS7505_FIXED_H
+
+#include "DS7505.h"
+
+//! DS7505 with its I2C address and initial resolution fixed at compile time
+/*!
+ * For boards where the A2, A1, A0 pins are hard wired. The address is an
+ * immediate operand of every bus access and the only per-object state is
+ * the cached configuration byte (one byte instead of two for DS7505).
+ * Conversion waits and thresholds follow that byte as in DS7505, so a
+ * resolution changed after init() through setConfig() is honoured.
+ * Each address instantiates its own members: past two or three sensors
+ * DS7505 (or DS7505Array) takes less flash.
+ *
+ * \code
+ *
+ *  DS7505Fixed<0, 0, 0, DS7505::RES_12> ds7505;
+ *
+ *  Wire.begin();
+ *  ds7505.init();
+ *  ds7505.setThermostatC(32.45f, 30.14f, DS7505::FT_6);
+ *
+ *  ds7505.waitConversion();
+ *  Serial.println(ds7505.getTempF());
+ *
+ * \endcode
+ *
+ * \tparam A2 MSB of the hardware configured I2C address
+ * \tparam A1 Bit a1 of the hardware configured I2C address
+ * \tparam A0 LSB of the hardware configured I2C address
+ * \tparam RES The temperature resolution set by init(), and the one
+ *   compile time Thresholds are encoded at
+ */
+template <uint8_t A2, uint8_t A1, uint8_t A0, DS7505::Resolution RES = DS7505::RES_12>
+class DS7505Fixed
+{
+
+public:
+
+  //! The I2C address, 1001A2A1A0
+  static const uint8_t i2cAddr = 0x48 | (A2 & 0x1) << 2 | (A1 & 0x1) << 1 | (A0 & 0x1);
+
+  //! Maximum conversion time in milliseconds at the configured resolution, the 12 bit one when unknown
+  uint8_t conversionTimeMs() const { return DS7505::conversionTimeMs(DS7505::cachedResolution(_configByte)); }
+
+  //! Default constructor.
+  DS7505Fixed() : _configByte(DS7505::CONF_UNKNOWN) {};
+
+  //! initialization, sets the resolution
+  void init() { setConfigRegister(DS7505::Config().resolution(RES).byte()); }
+
+  //! Get the raw value of the specified register, see DS7505::getRaw()
+  int16_t getRaw(DS7505::Register regPdef = DS7505::P_TEMP) { return DS7505::readRaw(i2cAddr, regPdef); }
+
+  //! Get the raw value of the specified register, see DS7505::getRaw(int16_t &, Register)
+  uint8_t getRaw(int16_t &raw, DS7505::Register regPdef = DS7505::P_TEMP) { return DS7505::readRaw(i2cAddr, regPdef, raw); }
+
+  //! Get the current temperature in Celsius. */
+  float getTempC() { return getTempC(DS7505::P_TEMP); }
+
+  //! Get the current temperature in Fahrenheit */
+  float getTempF() { return getTempF(DS7505::P_TEMP); }
+
+  //! Get the temperature specified by \ref regPdef in Celsius */
+  float getTempC(DS7505::Register regPdef) { return DS7505::decodeTemp(getRaw(regPdef)); }
+
+  //! Get the temperature specified by \ref regPdef in Fahrenheit */
+  float getTempF(DS7505::Register regPdef) { return DS7505::toFahrenheit(getTempC(regPdef)); }
+
+  //! Sets the thermostat temperature in Celsius
+  /*!
+   * \param tos trip temperature
+   * \param thyst hysteresis temperature
+   * \param ft fault tolerance (consecutive out-of-limits conversions before tripping)
+   * \return The thermostat programmed, see DS7505::setThermostatC()
+   */
+  DS7505::Thermostat setThermostatC(float tos, float thyst, DS7505::FaultTolerance ft = DS7505::FT_1)
+  {
+    return DS7505::setThermostat(i2cAddr, _configByte, tos, thyst, ft);
+  }
+
+  //! Sets the thermostat temperature in Fahrenheit
+  /*!
+   * \param tos trip temperature
+   * \param thyst hysteresis temperature
+   * \param ft fault tolerance (consecutive out-of-limits conversions before tripping)
+   * \return The thermostat programmed, see DS7505::setThermostatC()
+   */
+  DS7505::Thermostat setThermostatF(float tos, float thyst, DS7505::FaultTolerance ft = DS7505::FT_1)
+  {
+    return setThermostatC(DS7505::toCelsius(tos), DS7505::toCelsius(thyst), ft);
+  }
+
+  //! Sets the thermostat from raw register values, see DS7505::setThermostatRaw()
+  DS7505::Thermostat setThermostatRaw(int16_t tosRaw, int16_t thystRaw, DS7505::FaultTolerance ft)
+  {
+    return DS7505::setThermostatRaw(i2cAddr, _configByte, tosRaw, thystRaw, ft);
+  }
+
+#if __cplusplus >= 201103L
+  //! Sets the thermostat from compile time encoded settings
+  template <int16_t TosCenti, int16_t ThystCenti, DS7505::FaultTolerance FT>
+  DS7505::Thermostat setThermostat(DS7505::Thresholds<TosCenti, ThystCenti, FT, RES>)
+  {
+    return setThermostatRaw(DS7505::Thresholds<TosCenti, ThystCenti, FT, RES>::tos,
+                     DS7505::Thresholds<TosCenti, ThystCenti, FT, RES>::thyst, FT);
+  }
+#endif
+
+  //! Sets the configuration register, see DS7505::setConfigRegister()
+  uint8_t setConfigRegister(uint8_t configByte) { return DS7505::setConfigRegister(i2cAddr, _configByte, configByte); }
+
+  //! Sets the configuration register if it differs from the current one
+  uint8_t setConfig(DS7505::Config config) { return DS7505::setConfig(i2cAddr, _configByte, config); }
+
+  //! The configuration of the device, see DS7505::config()
+  DS7505::Config config() const { return DS7505::Config(_configByte); }
+
+  //! Send a command, see DS7505::sendCommand()
+  uint8_t sendCommand(uint8_t cmdSet) { return DS7505::sendCommand(i2cAddr, _configByte, cmdSet); }
+
+  //! Waits for a conversion to complete, see DS7505::waitConversion()
+  void waitConversion() { DS7505::wait(conversionTimeMs()); }
+
+private:
+  uint8_t _configByte;
+};
+
+#endif
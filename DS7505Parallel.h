@@ -0,0 +1,337 @@
+#ifndef DS7505_PARALLEL_H
+#define DS7505_PARALLEL_H
+
+#include "DS7505.h"
+#if defined(DS7505_ARDUINO)
+#include <pins_arduino.h>
+#endif
+
+//! Bit-banged I2C master clocking up to eight buses at once
+/*!
+ * The buses share SCL and each has its own SDA line, all SDA lines on one
+ * port: lane i is bit i of the port. The same transaction runs on every
+ * lane, so the devices must sit at the same address on each, and every
+ * bit read is sampled on all the lanes by a single port read. A lane
+ * whose device does not acknowledge is left out of the result and keeps
+ * being clocked with the others.
+ *
+ * \tparam Pins The lines, with sdaLow(lanes), sdaRelease(lanes), sda()
+ *   (the levels of the lanes), sclLow(), sclRelease(), scl() and wait()
+ *   (half a clock period), see DS7505PortPins on AVR boards and
+ *   DS7505SimPortPins on hosts
+ */
+template <typename Pins>
+class DS7505ParallelI2C
+{
+
+public:
+
+  //! Builds a master on \ref pins, clocking the \ref lanes given
+  DS7505ParallelI2C(const Pins &pins, uint8_t lanes, uint16_t stretch = 1000)
+    : pins(pins), lanes(lanes), stretch(stretch) {};
+
+  //! The lines
+  Pins pins;
+
+  //! The SDA lines used, bit i for lane i
+  uint8_t lanes;
+
+  //! Half periods a device may hold SCL low before the transaction fails
+  uint16_t stretch;
+
+  //! Releases every line
+  void begin() { pins.sdaRelease(lanes); pins.sclRelease(); }
+
+  //! Writes the same bytes to the device at \ref addr on every lane
+  /*!
+   * \return The lanes that acknowledged every byte, 0 on a bus timeout
+   */
+  uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n)
+  {
+    uint8_t acked = start(addr << 1);
+
+    for (uint8_t i = 0; i < n && acked; i++)
+      acked &= writeByte(data[i]);
+
+    return stop(acked);
+  }
+
+  //! Reads \ref n bytes from the device at \ref addr on every lane
+  /*!
+   * \param data Where to store the bytes, data[k][i] for byte k of lane i
+   * \return The lanes read, 0 on a bus timeout
+   */
+  uint8_t read(uint8_t addr, uint8_t data[][8], uint8_t n)
+  {
+    uint8_t acked = start(addr << 1 | 1);
+
+    for (uint8_t k = 0; k < n && acked; k++)
+      readByte(data[k], acked, k + 1 < n);
+
+    return stop(acked);
+  }
+
+private:
+  bool _timeout;
+
+  //! Releases SCL and waits for devices stretching it
+  void sclHigh()
+  {
+    pins.sclRelease();
+    for (uint16_t i = 0; !pins.scl(); i++) {
+      if (i == stretch) {
+        _timeout = true;
+        return;
+      }
+      pins.wait();
+    }
+  }
+
+  //! One clock with the \ref released lanes released, the others low
+  uint8_t clock(uint8_t released)
+  {
+    pins.sdaLow(lanes & ~released);
+    pins.sdaRelease(lanes & released);
+    pins.wait();
+    sclHigh();
+    pins.wait();
+    uint8_t sampled = pins.sda();
+    pins.sclLow();
+
+    return sampled;
+  }
+
+  //! Start condition and address byte, returns the lanes that acknowledged
+  uint8_t start(uint8_t addrRw)
+  {
+    _timeout = false;
+    begin();
+    sclHigh();
+    uint8_t idle = pins.sda() & lanes; // lanes held low by a device are out
+
+    pins.wait();
+    pins.sdaLow(lanes);
+    pins.wait();
+    pins.sclLow();
+
+    return idle & writeByte(addrRw);
+  }
+
+  //! Stop condition, passes \ref acked through
+  uint8_t stop(uint8_t acked)
+  {
+    pins.sdaLow(lanes);
+    pins.wait();
+    sclHigh();
+    pins.wait();
+    pins.sdaRelease(lanes);
+    pins.wait();
+
+    return _timeout ? 0 : acked;
+  }
+
+  //! Sends \ref b on every lane, returns the lanes that acknowledged
+  uint8_t writeByte(uint8_t b)
+  {
+    for (uint8_t mask = 0x80; mask; mask >>= 1)
+      clock(b & mask ? 0xFF : 0);
+
+    return ~clock(0xFF) & lanes;
+  }
+
+  //! Samples a byte on every lane and acknowledges it on the \ref acked ones
+  void readByte(uint8_t *bytes, uint8_t acked, bool ack)
+  {
+    uint8_t bits[8];
+
+    for (uint8_t j = 0; j < 8; j++)
+      bits[j] = clock(0xFF);
+    clock(ack ? ~acked : 0xFF);
+
+    // bit j of the port is lane j: transpose
+    for (uint8_t i = 0; i < 8; i++) {
+      uint8_t b = 0;
+
+      for (uint8_t j = 0; j < 8; j++)
+        b = b << 1 | (bits[j] >> i & 1);
+      bytes[i] = b;
+    }
+  }
+};
+
+//! Up to 8 x 8 DS7505 on up to eight buses read in parallel
+/*!
+ * Sensor (a, i) is the one at address 0x48 | a on lane i. A sweep reads
+ * every address once, all the lanes of an address at the same time: an
+ * 8 x 8 array takes the bus time of 8 reads instead of 64.
+ *
+ * \code
+ *
+ *  // SDA lines on PORTD bits 2 to 7 (digital 2 to 7, 0 and 1 are Serial), SCL on pin 8
+ *  DS7505Parallel<DS7505PortPins> grid(DS7505PortPins(2, 0xFC, 8), 0xFC);
+ *  int16_t raw[8][8];
+ *  uint8_t read[8];
+ *
+ *  grid.init(0xFF, DS7505::RES_12);
+ *  delay(grid.conversionTimeMs());
+ *  grid.sweep(raw, read);
+ *  if (read[2] & 1 << 5)
+ *    Serial.println(DS7505::decodeTemp(raw[2][5])); // 0x4A on lane 5
+ *
+ * \endcode
+ *
+ * \tparam Pins See DS7505ParallelI2C
+ */
+template <typename Pins>
+class DS7505Parallel
+{
+
+public:
+
+  //! Builds the array on \ref pins, clocking the \ref lanes given
+  DS7505Parallel(const Pins &pins, uint8_t lanes) : i2c(pins, lanes), _pointed(0), _configByte(0)
+  {
+    for (uint8_t a = 0; a < 8; a++)
+      _lanes[a] = 0;
+  }
+
+  //! The master
+  DS7505ParallelI2C<Pins> i2c;
+
+  //! Configures the sensors at the \ref addresses given on every lane
+  /*!
+   * \param addresses Bit a for address 0x48 | a
+   * \param res The temperature resolution of every sensor
+   * \return The number of sensors that acknowledged, the others are left out
+   */
+  uint8_t init(uint8_t addresses, DS7505::Resolution res)
+  {
+    uint8_t conf[2] = { DS7505::P_CONF, DS7505::Config().resolution(res).byte() };
+    uint8_t count = 0;
+
+    _configByte = conf[1];
+    _pointed = 0;
+    i2c.begin();
+    for (uint8_t a = 0; a < 8; a++) {
+      _lanes[a] = addresses & 1 << a ? i2c.write(0x48 | a, conf, 2) : 0;
+      for (uint8_t l = _lanes[a]; l; l &= l - 1)
+        count++;
+    }
+
+    return count;
+  }
+
+  //! Reads the temperature of the sensors at address 0x48 | \ref a on every lane
+  /*!
+   * \param raw Where to store the raw codes, raw[i] for lane i
+   * \return The lanes read
+   */
+  uint8_t read(uint8_t a, int16_t raw[8])
+  {
+    uint8_t bytes[2][8];
+    uint8_t addr = 0x48 | a;
+    uint8_t pointed = _lanes[a];
+
+    if (!pointed)
+      return 0;
+
+    // the pointer is the same on every lane, set once
+    if (!(_pointed & 1 << a)) {
+      uint8_t reg = DS7505::P_TEMP;
+
+      pointed &= i2c.write(addr, &reg, 1);
+      if (pointed == _lanes[a])
+        _pointed |= 1 << a;
+    }
+
+    uint8_t read = i2c.read(addr, bytes, 2) & pointed;
+    if (read != _lanes[a])
+      _pointed &= ~(1 << a); // a lane lost, point again next time
+
+    for (uint8_t i = 0; i < 8; i++)
+      if (read & 1 << i)
+        raw[i] = (int16_t) ((uint16_t) bytes[0][i] << 8 | bytes[1][i]);
+
+    return read;
+  }
+
+  //! Reads every sensor
+  /*!
+   * \param raw Where to store the raw codes, raw[a][i] for address 0x48 | a on lane i
+   * \param read Where to store the lanes read for each address
+   * \return The number of sensors read
+   */
+  uint8_t sweep(int16_t raw[8][8], uint8_t read[8])
+  {
+    uint8_t count = 0;
+
+    for (uint8_t a = 0; a < 8; a++) {
+      read[a] = this->read(a, raw[a]);
+      for (uint8_t l = read[a]; l; l &= l - 1)
+        count++;
+    }
+
+    return count;
+  }
+
+  //! The lanes holding a sensor at address 0x48 | \ref a
+  uint8_t lanes(uint8_t a) const { return _lanes[a]; }
+
+  //! Maximum conversion time in milliseconds, the useful sweep period
+  uint8_t conversionTimeMs() const { return DS7505::conversionTimeMs(DS7505::Config(_configByte).resolution()); }
+
+private:
+  uint8_t _lanes[8]; // lanes answering, by address
+  uint8_t _pointed; // addresses pointing at P_TEMP on every lane
+  uint8_t _configByte;
+};
+
+#if defined(DS7505_ARDUINO)
+//! The pins of one AVR port as SDA lines and any pin as SCL
+/*!
+ * Lines are released by making their pins inputs, pulled low by making
+ * them outputs, see DS7505Pins. Lane i is bit i of the port.
+ */
+class DS7505PortPins
+{
+
+public:
+
+  //! SDA on the \ref lanes of the port of pin \ref sda, SCL on pin \ref scl, clocked at most at \ref hz
+  DS7505PortPins(uint8_t sda, uint8_t lanes, uint8_t scl, uint32_t hz = 100000)
+    : _sclMask(digitalPinToBitMask(scl)),
+      _sdaMode(portModeRegister(digitalPinToPort(sda))), _sclMode(portModeRegister(digitalPinToPort(scl))),
+      _sdaIn(portInputRegister(digitalPinToPort(sda))), _sclIn(portInputRegister(digitalPinToPort(scl)))
+  {
+    *portOutputRegister(digitalPinToPort(sda)) &= ~lanes;
+    *portOutputRegister(digitalPinToPort(scl)) &= ~_sclMask;
+    setFrequency(hz);
+  }
+
+  //! Sets the SCL frequency, see DS7505Pins::setFrequency()
+  void setFrequency(uint32_t hz)
+  {
+    uint32_t half = hz == 0 || hz > 500000 ? 0 : 500000 / hz;
+
+    _halfUs = half > 255 ? 255 : half > 1 ? half - 1 : half;
+  }
+
+  void sdaRelease(uint8_t lanes) { *_sdaMode &= ~lanes; }
+  void sdaLow(uint8_t lanes) { *_sdaMode |= lanes; }
+  uint8_t sda() const { return *_sdaIn; }
+  void sclLow() { *_sclMode |= _sclMask; }
+  void sclRelease() { *_sclMode &= ~_sclMask; }
+  bool scl() const { return *_sclIn & _sclMask; }
+  void wait() const { if (_halfUs) delayMicroseconds(_halfUs); }
+
+private:
+  uint8_t _sclMask;
+  volatile uint8_t *_sdaMode;
+  volatile uint8_t *_sclMode;
+  volatile uint8_t *_sdaIn;
+  volatile uint8_t *_sclIn;
+  uint8_t _halfUs;
+};
+#endif
+
+#endif
@@ -0,0 +1,372 @@
+#include "DS7505Queue.h"
+#if defined(DS7505_TWI_QUEUE)
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/twi.h>
+
+#define TWCR_NEXT (_BV(TWEN) | _BV(TWIE) | _BV(TWINT))
+
+#if defined(__AVR_ATmega168__) || defined(__AVR_ATmega8__) || defined(__AVR_ATmega328P__)
+#define TWI_PORT PORTC
+#define TWI_DDR DDRC
+#define TWI_PIN PINC
+#define TWI_SDA _BV(4)
+#define TWI_SCL _BV(5)
+#else
+#define TWI_PORT PORTD
+#define TWI_DDR DDRD
+#define TWI_PIN PIND
+#define TWI_SDA _BV(1)
+#define TWI_SCL _BV(0)
+#endif
+
+DS7505Queue *DS7505Queue::_twi = 0;
+
+//the TWI interrupt steps the running operation
+ISR(TWI_vect)
+{
+  DS7505Queue::twi()->interrupt();
+}
+
+//internal pull-ups and bit rate as Wire sets them, then the TWI with its interrupt
+void DS7505Queue::begin(uint32_t hz)
+{
+  for (uint8_t i = 0; i < 8; i++)
+    links[i].pointer = 0;
+  _twi = this;
+
+  TWI_PORT |= TWI_SDA | TWI_SCL;
+  TWSR &= ~(_BV(TWPS0) | _BV(TWPS1));
+  TWBR = ((F_CPU / hz) - 16) / 2;
+  TWCR = _BV(TWEN) | _BV(TWIE);
+}
+
+//append op, starting the TWI when it is idle
+bool DS7505Queue::submit(Op &op)
+{
+  uint8_t sreg = SREG;
+  bool queued = false;
+
+  cli();
+  if (_count < DS7505_QUEUE_SIZE && op.status != ST_PENDING) {
+    op.status = ST_PENDING;
+    _ring[(_head + _count) % DS7505_QUEUE_SIZE] = &op;
+    _count++;
+    queued = true;
+
+    if (!_busy) {
+      _busy = true;
+      while (TWCR & _BV(TWSTO)) // the last stop is still going out
+        ;
+      start();
+      TWCR = TWCR_NEXT | _BV(TWSTA);
+    }
+  }
+  SREG = sreg;
+
+  return queued;
+}
+
+void DS7505Queue::poll()
+{
+}
+
+//queue op behind the others and wait for it, each operation running
+//DS7505_QUEUE_TIMEOUT_MS at most
+uint8_t DS7505Queue::wait(Op &op)
+{
+  unsigned long start = millis();
+  Op *running = 0;
+
+  while (!submit(op))
+    if (millis() - start >= DS7505_QUEUE_TIMEOUT_MS)
+      return DS7505::ST_TIMEOUT;
+
+  while (op.pending()) {
+    uint8_t sreg = SREG;
+
+    cli();
+    if (op.pending()) {
+      //timed from when an operation starts, not from when op was queued
+      if (_ring[_head] != running) {
+        running = _ring[_head];
+        start = millis();
+      }
+      else if (millis() - start >= DS7505_QUEUE_TIMEOUT_MS) {
+        cancel(*running); // it holds the bus, op may be the one
+      }
+    }
+    SREG = sreg;
+  }
+
+  return op.status;
+}
+
+//drop op, resetting the TWI when it is the one running, then call back
+void DS7505Queue::cancel(Op &op)
+{
+  uint8_t sreg = SREG;
+
+  cli();
+  for (uint8_t k = 0; k < _count; k++) {
+    if (_ring[(_head + k) % DS7505_QUEUE_SIZE] != &op)
+      continue;
+
+    if (k == 0) {
+      links[op.addr & 0x7].pointer = 0;
+      recover();
+      finish(DS7505::ST_TIMEOUT);
+      break;
+    }
+
+    for (; k + 1 < _count; k++)
+      _ring[(_head + k) % DS7505_QUEUE_SIZE] = _ring[(_head + k + 1) % DS7505_QUEUE_SIZE];
+    _count--;
+
+    op.status = DS7505::ST_TIMEOUT;
+    if (op.done)
+      op.done(op);
+    break;
+  }
+  SREG = sreg;
+}
+
+//TWI off, SCL pulsed until a device holding SDA lets go, a start and
+//a stop by hand so every device sees the bus free, then the TWI back
+void DS7505Queue::recover()
+{
+  TWCR = 0;
+
+  for (uint8_t i = 0; i < 9 && !(TWI_PIN & TWI_SDA); i++) {
+    TWI_PORT &= ~TWI_SCL;
+    TWI_DDR |= TWI_SCL;
+    delayMicroseconds(5);
+    TWI_DDR &= ~TWI_SCL;
+    TWI_PORT |= TWI_SCL;
+    delayMicroseconds(5);
+  }
+
+  //SDA falling then rising while SCL is high
+  TWI_PORT &= ~TWI_SDA;
+  TWI_DDR |= TWI_SDA;
+  delayMicroseconds(5);
+  TWI_DDR &= ~TWI_SDA;
+  TWI_PORT |= TWI_SDA;
+  delayMicroseconds(5);
+
+  TWCR = _BV(TWEN) | _BV(TWIE);
+}
+
+//the driver's transactions queue behind the others
+uint8_t DS7505Queue::write(uint8_t addr, const uint8_t *data, uint8_t n)
+{
+  Op op;
+
+  if (n == 0 || n > 4)
+    return DS7505::ST_TOO_LONG;
+
+  op.addr = addr;
+  op.reg = data[0];
+  op.n = n - 1;
+  for (uint8_t i = 1; i < n; i++)
+    op.data[i - 1] = data[i];
+
+  return wait(op);
+}
+
+//the pointer is checked when the read runs, not now
+uint8_t DS7505Queue::read(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n)
+{
+  Op op;
+  uint8_t status;
+
+  if (n == 0 || n > 3)
+    return DS7505::ST_TOO_LONG;
+
+  op.addr = addr;
+  op.reg = reg;
+  op.n = n;
+  op.read = true;
+
+  if ((status = wait(op)) == DS7505::ST_OK)
+    for (uint8_t i = 0; i < n; i++)
+      data[i] = op.data[i];
+
+  return status;
+}
+
+//prepare the operation at the head, its start condition is up to the caller
+void DS7505Queue::start()
+{
+  Op &op = *_ring[_head];
+
+  _i = 0;
+  _pointing = op.read && op.reg <= DS7505::P_TOS && links[op.addr & 0x7].pointer != op.reg + 1;
+}
+
+//one TWI event: address, pointer, data, acknowledges
+void DS7505Queue::interrupt()
+{
+  Op &op = *_ring[_head];
+  DS7505::Link &link = links[op.addr & 0x7];
+
+  switch (TW_STATUS) {
+  case TW_START:
+  case TW_REP_START:
+    TWDR = op.addr << 1 | (op.read && !_pointing ? TW_READ : TW_WRITE);
+    TWCR = TWCR_NEXT;
+    break;
+
+  case TW_MT_SLA_ACK:
+    TWDR = op.reg;
+    TWCR = TWCR_NEXT;
+    break;
+
+  case TW_MT_DATA_ACK:
+    if (_pointing) {
+      //pointer set, read through a repeated start
+      link.pointer = op.reg + 1;
+      _pointing = false;
+      TWCR = TWCR_NEXT | _BV(TWSTA);
+    }
+    else if (_i < op.n) {
+      TWDR = op.data[_i++];
+      TWCR = TWCR_NEXT;
+    }
+    else {
+      //commands leave the pointer in an unknown state
+      link.pointer = op.reg <= DS7505::P_TOS ? op.reg + 1 : 0;
+      finish(DS7505::ST_OK);
+    }
+    break;
+
+  case TW_MR_SLA_ACK:
+    TWCR = TWCR_NEXT | (op.n > 1 ? _BV(TWEA) : 0);
+    break;
+
+  case TW_MR_DATA_ACK:
+    op.data[_i++] = TWDR;
+    TWCR = TWCR_NEXT | (_i + 1 < op.n ? _BV(TWEA) : 0);
+    break;
+
+  case TW_MR_DATA_NACK:
+    op.data[_i++] = TWDR;
+    finish(DS7505::ST_OK);
+    break;
+
+  case TW_MT_SLA_NACK:
+  case TW_MR_SLA_NACK:
+    finish(DS7505::ST_NACK_ADDR);
+    break;
+
+  case TW_MT_DATA_NACK:
+    link.pointer = 0;
+    finish(DS7505::ST_NACK_DATA);
+    break;
+
+  default: // arbitration lost, bus error
+    link.pointer = 0;
+    finish(DS7505::ST_ERROR);
+    break;
+  }
+}
+
+//pop the head, go on with the next operation or stop, then call back
+void DS7505Queue::finish(uint8_t status)
+{
+  Op &op = *_ring[_head];
+
+  _head = (_head + 1) % DS7505_QUEUE_SIZE;
+  _count--;
+
+  if (_count) {
+    start();
+    TWCR = TWCR_NEXT | _BV(TWSTA);
+  }
+  else {
+    _busy = false;
+    TWCR = TWCR_NEXT | _BV(TWSTO);
+  }
+
+  op.status = status;
+  if (op.done)
+    op.done(op);
+}
+#else
+void DS7505Queue::begin(uint32_t)
+{
+}
+
+//append op, poll() runs it
+bool DS7505Queue::submit(Op &op)
+{
+  if (_count == DS7505_QUEUE_SIZE || op.status == ST_PENDING)
+    return false;
+
+  op.status = ST_PENDING;
+  _ring[(_head + _count) % DS7505_QUEUE_SIZE] = &op;
+  _count++;
+
+  return true;
+}
+
+//run the queue through the driver, including what callbacks submit
+void DS7505Queue::poll()
+{
+  if (_busy)
+    return; // called back from a callback
+
+  _busy = true;
+  while (_count) {
+    Op &op = *_ring[_head];
+
+    if (op.read)
+      op.status = DS7505::readRegister(op.addr, op.reg, op.data, op.n);
+    else
+      op.status = DS7505::writeRegister(op.addr, op.reg, op.data, op.n);
+
+    _head = (_head + 1) % DS7505_QUEUE_SIZE;
+    _count--;
+    if (op.done)
+      op.done(op);
+  }
+  _busy = false;
+}
+#endif
+
+//one read per sensor, all queued or none
+bool DS7505Sweep::start(DS7505Queue &queue, uint8_t mask)
+{
+  uint8_t n = 0;
+
+  for (uint8_t m = mask; m; m &= m - 1)
+    n++;
+  if (_pending || queue.room() < n)
+    return false;
+
+  read = 0;
+  _pending = mask;
+  for (uint8_t i = 0; i < 8; i++) {
+    if (!(mask & 1 << i))
+      continue;
+
+    _ops[i].readRaw(0x48 | i).done = complete;
+    _ops[i].context = this;
+    queue.submit(_ops[i]);
+  }
+
+  return true;
+}
+
+//store the code of a sensor, from the interrupt with DS7505_TWI_QUEUE
+void DS7505Sweep::complete(DS7505Queue::Op &op)
+{
+  DS7505Sweep *sweep = (DS7505Sweep *) op.context;
+  uint8_t i = op.addr & 0x7;
+
+  if (op.status == DS7505::ST_OK) {
+    sweep->raw[i] = op.raw();
+    sweep->read |= 1 << i;
+  }
+  sweep->_pending &= ~(1 << i);
+}
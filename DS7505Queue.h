@@ -0,0 +1,225 @@
+#ifndef DS7505_QUEUE_H
+#define DS7505_QUEUE_H
+
+#include "DS7505.h"
+
+// Number of operations a DS7505Queue holds
+#ifndef DS7505_QUEUE_SIZE
+#define DS7505_QUEUE_SIZE 8
+#endif
+
+// Time an operation may run while the driver waits on the queue, in ms
+#ifndef DS7505_QUEUE_TIMEOUT_MS
+#define DS7505_QUEUE_TIMEOUT_MS 50
+#endif
+
+//! A queue of DS7505 bus operations run in the background
+/*!
+ * Operations are built once (see Op) and submitted as often as needed;
+ * the queue only holds pointers to them. With DS7505_TWI_QUEUE defined
+ * (AVR boards) the TWI interrupt runs them back to back, a repeated start
+ * between two of them, and calls their completion callback: the main loop
+ * only submits and collects results, see DS7505Sweep. The queue then also
+ * is the bus of the driver instead of Wire, its blocking transfers waiting
+ * in line behind the queued operations. Each operation gets
+ * DS7505_QUEUE_TIMEOUT_MS once it runs: past it the operation is taken
+ * to hold the bus and cancelled, see cancel(); the ones queued behind
+ * then run, each timed anew.
+ * A read names its register and the interrupt points the device at it
+ * when the read runs, so operations queued ahead moving the pointer do
+ * no harm.
+ *
+ * Elsewhere (Maple, hosts, AVR boards on Wire) the operations are run by
+ * poll() on the bus of the driver, callbacks included.
+ *
+ * \code
+ *
+ *  DS7505Queue queue;
+ *  DS7505Array sensors;
+ *  DS7505Sweep sweep;
+ *
+ *  queue.begin(400000); // instead of Wire.begin()
+ *  sensors.init(0xFF, DS7505::RES_12);
+ *
+ *  sweep.start(queue, sensors.mask());
+ *  // ... anything, then once sweep.done():
+ *  Serial.println(DS7505::decodeTemp(sweep.raw[3]));
+ *
+ * \endcode
+ */
+class DS7505Queue
+{
+
+public:
+
+  //! Status of an operation waiting in the queue or running
+  static const uint8_t ST_PENDING = 0xFF;
+
+  //! One transaction on the bus
+  struct Op {
+    uint8_t addr; /*!< I2C address */
+    uint8_t reg; /*!< register pointed at, read or written */
+    uint8_t n; /*!< bytes read, or written after the pointer */
+    bool read; /*!< read rather than write */
+    uint8_t data[3]; /*!< bytes read or written, MSB first */
+    volatile uint8_t status; /*!< a DS7505::Status, ST_PENDING until the operation is over */
+    void (*done)(Op &op); /*!< called once over, from the interrupt with DS7505_TWI_QUEUE */
+    void *context; /*!< left to the callback */
+
+    Op() : n(0), read(false), status(DS7505::ST_OK), done(0), context(0) {};
+
+    //! Sets the pointer of the device at \ref addr to \ref reg
+    Op &pointTo(uint8_t addr, DS7505::Register reg) { return set(addr, reg, 0, false); }
+
+    //! Reads the 2 bytes of a temperature register
+    /*!
+     * The pointer is written first, in the same transaction through a
+     * repeated start, only when the device does not point at \ref reg yet.
+     */
+    Op &readRaw(uint8_t addr, DS7505::Register reg = DS7505::P_TEMP) { return set(addr, reg, 2, true); }
+
+    //! Writes a temperature register, pointer and 2 bytes
+    Op &writeRaw(uint8_t addr, DS7505::Register reg, int16_t raw)
+    {
+      data[0] = (uint16_t) raw >> 8;
+      data[1] = raw & 0xFF;
+      return set(addr, reg, 2, false);
+    }
+
+    //! The 2 bytes read as a raw code, see DS7505::decodeTemp()
+    int16_t raw() const { return (int16_t) ((uint16_t) data[0] << 8 | data[1]); }
+
+    //! Whether the operation is queued or running
+    bool pending() const { return status == ST_PENDING; }
+
+  private:
+    Op &set(uint8_t addr, uint8_t reg, uint8_t n, bool read)
+    {
+      this->addr = addr;
+      this->reg = reg;
+      this->n = n;
+      this->read = read;
+      return *this;
+    }
+  };
+
+  //! Default constructor.
+  DS7505Queue() : _head(0), _count(0), _busy(false) {};
+
+  //! initialization, takes over the TWI with DS7505_TWI_QUEUE
+  /*!
+   * Does nothing otherwise, the bus of the driver is set up as usual.
+   * \param hz SCL frequency, 400 kHz at most for the DS7505
+   */
+  void begin(uint32_t hz = 100000);
+
+  //! Queues an operation
+  /*!
+   * The operation must stay in place until it is over. Callable from a
+   * callback, to chain operations.
+   * \return false when the queue is full or \ref op is already pending
+   */
+  bool submit(Op &op);
+
+  //! Runs the queued operations, a no-op with DS7505_TWI_QUEUE
+  void poll();
+
+  //! Whether every operation submitted is over
+  bool idle() const { return !_count; }
+
+  //! Operations that can be submitted before the queue is full
+  uint8_t room() const { return DS7505_QUEUE_SIZE - _count; }
+
+#if defined(DS7505_TWI_QUEUE)
+  //! Write transaction for the driver, waits for the queue
+  /*!
+   * Must not be called from a callback.
+   * \return A DS7505::Status, ST_TOO_LONG beyond pointer + 3 bytes,
+   *   ST_TIMEOUT when it did not run within DS7505_QUEUE_TIMEOUT_MS or
+   *   could not be queued in that time
+   */
+  uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n);
+
+  //! Reads \ref n bytes of register \ref reg for the driver, waits for the queue
+  /*!
+   * Must not be called from a callback.
+   * \return A DS7505::Status, ST_TOO_LONG beyond 3 bytes,
+   *   ST_TIMEOUT when it did not run within DS7505_QUEUE_TIMEOUT_MS or
+   *   could not be queued in that time
+   */
+  uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n);
+
+  //! Takes \ref op out of the queue, ST_TIMEOUT, when it is not over yet
+  /*!
+   * A running operation is cut short: the TWI is turned off, SCL pulsed
+   * until a device holding SDA releases it and the bus closed with a
+   * stop, then the next operation starts. The callback is called as for
+   * any operation over.
+   */
+  void cancel(Op &op);
+
+  //! Bus state of the devices on the TWI, by address & 0x7
+  DS7505::Link links[8];
+
+  //! The queue running the TWI, set by begin()
+  static DS7505Queue *twi() { return _twi; }
+
+  //! Next step of the running operation, from the TWI interrupt
+  void interrupt();
+#endif
+
+private:
+  Op *_ring[DS7505_QUEUE_SIZE];
+  volatile uint8_t _head; // index of the running operation
+  volatile uint8_t _count;
+  volatile bool _busy; // an operation is running
+#if defined(DS7505_TWI_QUEUE)
+  uint8_t _i; // bytes of the running operation transferred
+  bool _pointing; // writing the pointer ahead of a read
+  static DS7505Queue *_twi;
+
+  void start();
+  void finish(uint8_t status);
+  void recover();
+  uint8_t wait(Op &op);
+#endif
+};
+
+//! The temperature of up to eight sensors read through a DS7505Queue
+/*!
+ * One readRaw() operation per sensor, the results landing in \ref raw
+ * as the operations complete.
+ */
+class DS7505Sweep
+{
+
+public:
+
+  //! Default constructor.
+  DS7505Sweep() : read(0), _pending(0) {};
+
+  //! Queues a read of P_TEMP of the sensors in \ref mask
+  /*!
+   * \param queue The queue
+   * \param mask Bit i for address 0x48 | i, see DS7505Array::mask()
+   * \return false when the previous sweep is not over or the queue lacks room
+   */
+  bool start(DS7505Queue &queue, uint8_t mask);
+
+  //! Whether every read is over
+  bool done() const { return !_pending; }
+
+  //! Raw codes, raw[i] for address 0x48 | i
+  int16_t raw[8];
+
+  //! The sensors read by the sweep, the other entries of \ref raw are untouched
+  volatile uint8_t read;
+
+private:
+  DS7505Queue::Op _ops[8];
+  volatile uint8_t _pending;
+
+  static void complete(DS7505Queue::Op &op);
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef DS7505_ROLLUP_H
+#define DS7505_ROLLUP_H
+
+#include "DS7505.h"
+
+//! min/max/sum/count of the raw codes of one time bucket
+/*!
+ * \tparam Sum Must hold Count times 32767
+ * \tparam Count Must hold the samples of one bucket of the coarsest level
+ */
+template <typename Sum, typename Count>
+struct DS7505Bucket
+{
+  int16_t min;
+  int16_t max;
+  Sum sum;
+  Count count;
+
+  DS7505Bucket() { clear(); };
+
+  void clear() { min = 0x7FFF; max = -0x7FFF - 1; sum = 0; count = 0; }
+
+  void add(int16_t raw)
+  {
+    if (raw < min) min = raw;
+    if (raw > max) max = raw;
+    sum += raw;
+    count++;
+  }
+
+  void add(const DS7505Bucket &b)
+  {
+    if (b.min < min) min = b.min;
+    if (b.max > max) max = b.max;
+    sum += b.sum;
+    count += b.count;
+  }
+
+  //! Mean raw code, DS7505::decodeTemp() scale, 0 when empty
+  float mean() const { return count ? (float) sum / count : 0; }
+};
+
+//! The last N buckets of PERIOD seconds, in a ring
+/*!
+ * add() updates the current bucket and only divides when the time leaves
+ * it; moving on clears the buckets skipped, at most N.
+ */
+template <uint8_t N, uint16_t PERIOD, typename Sum, typename Count>
+class DS7505Level
+{
+
+public:
+
+  typedef DS7505Bucket<Sum, Count> Bucket;
+
+  //! Default constructor.
+  DS7505Level() : _slot(0), _end(PERIOD), _head(0) {};
+
+  //! Adds a sample
+  /*!
+   * \param t The time in seconds
+   * \param raw The raw code
+   */
+  void add(uint32_t t, int16_t raw)
+  {
+    if (t >= _end) {
+      advance(t / PERIOD);
+    }
+    else if (t < _end - PERIOD) {
+      // late sample, kept if its bucket still is
+      if (holds(t)) _buckets[index(t / PERIOD)].add(raw);
+      return;
+    }
+
+    _buckets[_head].add(raw);
+  }
+
+  //! Whether the bucket holding time \ref t is in the window
+  bool holds(uint32_t t) const { uint32_t slot = t / PERIOD; return slot <= _slot && _slot - slot < N; }
+
+  //! The bucket holding time \ref t, which must be in the window
+  const Bucket &at(uint32_t t) const { return _buckets[index(t / PERIOD)]; }
+
+  //! Start of the oldest bucket in the window, in seconds
+  uint32_t oldest() const { return _slot < N ? 0 : (_slot - N + 1) * PERIOD; }
+
+  //! End of the current bucket, in seconds
+  uint32_t end() const { return _end; }
+
+private:
+  Bucket _buckets[N];
+  uint32_t _slot; // current bucket, time / PERIOD
+  uint32_t _end; // end of the current bucket
+  uint8_t _head; // index of the current bucket
+
+  uint8_t index(uint32_t slot) const { return (_head + N - (_slot - slot)) % N; }
+
+  void advance(uint32_t slot)
+  {
+    uint32_t gap = slot - _slot;
+
+    for (gap = gap < N ? gap : N; gap > 0; gap--) {
+      _head = _head + 1 == N ? 0 : _head + 1;
+      _buckets[_head].clear();
+    }
+
+    _slot = slot;
+    _end = (slot + 1) * PERIOD;
+  }
+};
+
+//! Incremental second / minute / hour rollups of a sample stream
+/*!
+ * Every sample updates one bucket per level in constant time, memory is
+ * fixed at (S + M + H) buckets. Windows ending now are answered from the
+ * coarsest buckets that fit instead of the samples.
+ *
+ * \code
+ *
+ *  // last 10 s, 15 min and 24 h: 49 buckets of 10 bytes
+ *  DS7505Rollup<10, 15, 24> history;
+ *
+ *  history.add(millis() / 1000, ds7505.getRaw());
+ *
+ *  uint32_t now = millis() / 1000;
+ *  Serial.println(DS7505::decodeTemp(history.query(now - 3599, now).max));
+ *
+ * \endcode
+ *
+ * The default buckets hold 65535 samples, one hour at 18 Hz; hosts
+ * sampling faster use int64_t / uint32_t.
+ *
+ * \tparam S Seconds kept, at most 60 * M
+ * \tparam M Minutes kept, at most 60 * H
+ * \tparam H Hours kept
+ */
+template <uint8_t S, uint8_t M, uint8_t H, typename Sum = int32_t, typename Count = uint16_t>
+class DS7505Rollup
+{
+
+public:
+
+  typedef DS7505Bucket<Sum, Count> Bucket;
+
+  DS7505Level<S, 1, Sum, Count> seconds;
+  DS7505Level<M, 60, Sum, Count> minutes;
+  DS7505Level<H, 3600, Sum, Count> hours;
+
+  //! Adds a sample
+  /*!
+   * \param t The time in seconds, late samples only reach the buckets still kept
+   * \param raw The raw code
+   */
+  void add(uint32_t t, int16_t raw)
+  {
+    seconds.add(t, raw);
+    minutes.add(t, raw);
+    hours.add(t, raw);
+  }
+
+  //! Summary of the samples in [t0, t1]
+  /*!
+   * Exact down to the second while the seconds level still holds the ends
+   * of the range, otherwise the ends are widened to the enclosing minute or
+   * hour. At most 2 * (60 + 60) + H buckets are merged.
+   */
+  Bucket query(uint32_t t0, uint32_t t1) const
+  {
+    Bucket r;
+
+    // nothing is kept out of the hours window
+    if (t0 < hours.oldest()) t0 = hours.oldest();
+    if (t1 >= hours.end()) t1 = hours.end() - 1;
+
+    for (uint32_t t = t0; t <= t1 && t >= t0; ) {
+      uint32_t next;
+
+      if (t % 3600 == 0 && t1 - t >= 3599) {
+        if (hours.holds(t)) r.add(hours.at(t));
+        next = t + 3600;
+      }
+      else if (t % 60 == 0 && t1 - t >= 59 && minutes.holds(t)) {
+        r.add(minutes.at(t));
+        next = t + 60;
+      }
+      else if (seconds.holds(t)) {
+        r.add(seconds.at(t));
+        next = t + 1;
+      }
+      else if (minutes.holds(t)) {
+        r.add(minutes.at(t));
+        next = t - t % 60 + 60;
+      }
+      else {
+        if (hours.holds(t)) r.add(hours.at(t));
+        next = t - t % 3600 + 3600;
+      }
+
+      t = next; // wraps to below t0 past 2^32 - 1
+    }
+
+    return r;
+  }
+};
+
+#endif
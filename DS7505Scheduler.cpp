@@ -0,0 +1,93 @@
+#include "DS7505Scheduler.h"
+
+//configure the sensor at its resolution, its first sample due once converted at it
+bool DS7505Scheduler::add(uint8_t i, uint16_t periodMs, DS7505::Resolution res, uint32_t now)
+{
+  uint8_t configByte = DS7505::Config().resolution(res).byte();
+
+  if (!(_array.mask() & 1 << i) || periodMs == 0 || DS7505::conversionTimeMs(res) > periodMs)
+    return false;
+
+  if (DS7505::writeRegister(0x48 | i, DS7505::P_CONF, &configByte, 1) != DS7505::ST_OK)
+    return false;
+
+  _tasks[i].release = now + DS7505::conversionTimeMs(res);
+  _tasks[i].period = periodMs;
+  _tasks[i].misses = 0;
+  _tasks[i].started = false;
+  _mask |= 1 << i;
+
+  return true;
+}
+
+//earliest deadlines among the released sensors, read in one sweep
+uint8_t DS7505Scheduler::run(uint32_t now, int16_t raw[8])
+{
+  uint8_t due = 0;
+
+  //the window only adds to a sweep that is due anyway
+  if ((int32_t) (now - next()) < 0)
+    return 0;
+
+  for (uint8_t n = 0; n < budget; n++) {
+    int8_t best = -1;
+    uint32_t deadline = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+      const Task &t = _tasks[i];
+
+      //the first sample waits for its conversion, not the window
+      if (!(_mask & ~due & 1 << i) || (int32_t) (now + (t.started ? window : 0) - t.release) < 0)
+        continue;
+
+      if (best < 0 || (int32_t) (t.release + t.period - deadline) < 0) {
+        best = i;
+        deadline = t.release + t.period;
+      }
+    }
+
+    if (best < 0)
+      break;
+    due |= 1 << best;
+  }
+
+  if (!due)
+    return 0;
+
+  uint8_t read = _array.sweep(raw, due);
+
+  //next release on the grid, past the periods missed
+  for (uint8_t i = 0; i < 8; i++) {
+    if (!(read & 1 << i))
+      continue;
+
+    Task &t = _tasks[i];
+    int32_t late = (int32_t) (now - t.release);
+    uint32_t missed = late > 0 ? (uint32_t) late / t.period : 0;
+
+    t.misses = missed < 0xFFFFu - t.misses ? t.misses + missed : 0xFFFF;
+    t.started = true;
+    t.release += (missed + 1) * t.period;
+  }
+
+  return read;
+}
+
+//earliest release
+uint32_t DS7505Scheduler::next() const
+{
+  uint32_t next = 0;
+  bool found = false;
+
+  for (uint8_t i = 0; i < 8; i++) {
+    if (!(_mask & 1 << i))
+      continue;
+
+    uint32_t t = _tasks[i].release;
+    if (!found || (int32_t) (t - next) < 0)
+      next = t;
+    found = true;
+  }
+
+  return next;
+}
@@ -0,0 +1,103 @@
+#ifndef DS7505_SCHEDULER_H
+#define DS7505_SCHEDULER_H
+
+#include "DS7505Array.h"
+
+//! Sensors of a DS7505Array sampled at rates of their own
+/*!
+ * Each sensor has a period and a resolution, its conversion time at most
+ * the period. Sample k of a sensor is released at start + conversion
+ * time + k * period, the first one a complete conversion at the new
+ * resolution, and due before the next release, its deadline. run() reads the released
+ * sensors, earliest deadline first, in one sweep of the array: sensors
+ * released within \ref window after now join it early rather than cost
+ * a wake-up of their own (not the first sample, which must wait for a
+ * conversion at the new resolution), and at most \ref budget sensors are read per
+ * run when the bus time is short. A sample read past its deadline misses
+ * every period it stayed unread; the next release stays on the grid of
+ * the period, so lateness never accumulates.
+ *
+ * Times are in milliseconds, millis() on boards, and may wrap.
+ *
+ * \code
+ *
+ *  DS7505Array sensors;
+ *  DS7505Scheduler scheduler(sensors);
+ *  int16_t raw[8];
+ *
+ *  Wire.begin();
+ *  sensors.init(0x0F, DS7505::RES_12);
+ *  scheduler.add(0, 250, DS7505::RES_11, millis()); // 4 Hz
+ *  scheduler.add(1, 250, DS7505::RES_11, millis());
+ *  scheduler.add(2, 60000, DS7505::RES_12, millis()); // once a minute
+ *  scheduler.add(3, 60000, DS7505::RES_12, millis());
+ *
+ *  uint8_t read = scheduler.run(millis(), raw);
+ *  // ... sleep until scheduler.next()
+ *
+ * \endcode
+ */
+class DS7505Scheduler
+{
+
+public:
+
+  //! Schedules sensors of \ref array
+  explicit DS7505Scheduler(DS7505Array &array) : window(0), budget(8), _array(array), _mask(0) {};
+
+  //! Sensors released up to this many ms after now join a sweep, from their second sample on
+  uint16_t window;
+
+  //! Sensors read by one run() at most, earliest deadlines first
+  uint8_t budget;
+
+  //! Schedules sensor \ref i, its first sample released once converted at \ref res
+  /*!
+   * Writes the resolution to the sensor, DS7505Array::resolution() only
+   * stands for the others.
+   * \param i The sensor, address 0x48 | i
+   * \param periodMs The sampling period, 1 ms to 65 s
+   * \param res The resolution, its conversion time at most \ref periodMs
+   * \param now The time, the first release is now + DS7505::conversionTimeMs(res)
+   * \return false when the sensor is not in the array, the period too
+   *   short for the resolution or the configuration write failed
+   */
+  bool add(uint8_t i, uint16_t periodMs, DS7505::Resolution res, uint32_t now);
+
+  //! Stops sampling sensor \ref i
+  void remove(uint8_t i) { _mask &= ~(1 << i); }
+
+  //! Reads the sensors due at \ref now
+  /*!
+   * \param now The time
+   * \param raw Where to store the raw codes, raw[i] for address 0x48 | i
+   * \return The sensors read, the other entries of \ref raw are untouched
+   */
+  uint8_t run(uint32_t now, int16_t raw[8]);
+
+  //! The time run() next has a sensor to read, the earliest release
+  uint32_t next() const;
+
+  //! The release of the next sample of sensor \ref i
+  uint32_t release(uint8_t i) const { return _tasks[i].release; }
+
+  //! Periods sensor \ref i went unsampled, stuck at 65535 once there
+  uint16_t misses(uint8_t i) const { return _tasks[i].misses; }
+
+  //! The sensors scheduled
+  uint8_t mask() const { return _mask; }
+
+private:
+  struct Task {
+    uint32_t release; // ms
+    uint16_t period; // ms
+    uint16_t misses;
+    bool started; // a sample was read, the window may advance the next ones
+  };
+
+  DS7505Array &_array;
+  Task _tasks[8];
+  uint8_t _mask;
+};
+
+#endif
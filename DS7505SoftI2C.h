@@ -0,0 +1,274 @@
+#ifndef DS7505_SOFT_I2C_H
+#define DS7505_SOFT_I2C_H
+
+#include "DS7505.h"
+#if defined(DS7505_ARDUINO)
+#include <pins_arduino.h>
+#endif
+#if !defined(DS7505_HOST)
+#include "DS7505Transport.h"
+#endif
+
+//! Bit-banged I2C master over two open drain lines
+/*!
+ * Lines are driven low or released to their pull-ups, never driven high,
+ * so devices may stretch the clock: after releasing SCL the master waits
+ * for it to go high, at most \ref stretch half periods.
+ *
+ * \tparam Pins The lines, with sdaLow(), sdaRelease(), sda(), sclLow(),
+ *   sclRelease(), scl() and wait() (half a clock period), see DS7505Pins
+ *   on boards and DS7505SimPins on hosts
+ */
+template <typename Pins>
+class DS7505SoftI2C
+{
+
+public:
+
+  //! Builds a master on \ref pins, both lines released
+  DS7505SoftI2C(const Pins &pins, uint16_t stretch = 1000) : pins(pins), stretch(stretch) {};
+
+  //! The lines
+  Pins pins;
+
+  //! Half periods a device may hold SCL low before ST_TIMEOUT
+  uint16_t stretch;
+
+  //! Releases both lines
+  void begin() { pins.sdaRelease(); pins.sclRelease(); }
+
+  //! Write transaction: start, address + W, \ref n bytes, stop
+  /*!
+   * \return A DS7505::Status
+   */
+  uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n)
+  {
+    uint8_t status = start(addr << 1);
+
+    for (uint8_t i = 0; i < n && status == DS7505::ST_OK; i++)
+      status = writeByte(data[i]);
+
+    return stop(status);
+  }
+
+  //! Read transaction: start, address + R, \ref n bytes, stop
+  /*!
+   * \return A DS7505::Status
+   */
+  uint8_t read(uint8_t addr, uint8_t *data, uint8_t n)
+  {
+    uint8_t status = start(addr << 1 | 1);
+
+    for (uint8_t i = 0; i < n && status == DS7505::ST_OK; i++)
+      status = readByte(data[i], i + 1 < n);
+
+    return stop(status);
+  }
+
+private:
+  //! Releases SCL and waits for devices stretching it
+  bool sclHigh()
+  {
+    pins.sclRelease();
+    for (uint16_t i = 0; !pins.scl(); i++) {
+      if (i == stretch)
+        return false;
+      pins.wait();
+    }
+
+    return true;
+  }
+
+  //! One clock with SDA set to \ref bit, returns SDA as sampled
+  bool clock(bool bit, uint8_t &status)
+  {
+    if (bit)
+      pins.sdaRelease();
+    else
+      pins.sdaLow();
+    pins.wait();
+    if (!sclHigh())
+      status = DS7505::ST_TIMEOUT;
+    pins.wait();
+    bool sampled = pins.sda();
+    pins.sclLow();
+
+    return sampled;
+  }
+
+  //! Start condition and address byte
+  uint8_t start(uint8_t addrRw)
+  {
+    begin();
+    if (!sclHigh())
+      return DS7505::ST_TIMEOUT;
+    if (!pins.sda())
+      return DS7505::ST_ERROR; // a device holds the bus
+
+    pins.wait();
+    pins.sdaLow();
+    pins.wait();
+    pins.sclLow();
+
+    uint8_t status = writeByte(addrRw);
+    return status == DS7505::ST_NACK_DATA ? (uint8_t) DS7505::ST_NACK_ADDR : status;
+  }
+
+  //! Stop condition, passes \ref status through
+  uint8_t stop(uint8_t status)
+  {
+    pins.sdaLow();
+    pins.wait();
+    if (!sclHigh() && status == DS7505::ST_OK)
+      status = DS7505::ST_TIMEOUT;
+    pins.wait();
+    pins.sdaRelease();
+    pins.wait();
+
+    return status;
+  }
+
+  uint8_t writeByte(uint8_t b)
+  {
+    uint8_t status = DS7505::ST_OK;
+
+    for (uint8_t mask = 0x80; mask; mask >>= 1)
+      clock(b & mask, status);
+
+    bool nack = clock(true, status);
+    if (status != DS7505::ST_OK)
+      return status;
+
+    return nack ? DS7505::ST_NACK_DATA : DS7505::ST_OK;
+  }
+
+  uint8_t readByte(uint8_t &b, bool ack)
+  {
+    uint8_t status = DS7505::ST_OK;
+
+    b = 0;
+    for (uint8_t i = 0; i < 8; i++)
+      b = b << 1 | clock(true, status);
+    clock(!ack, status);
+
+    return status;
+  }
+};
+
+#if defined(DS7505_ARDUINO)
+//! Two pins of an AVR board as open drain lines
+/*!
+ * A line is released by making its pin an input, pulled low by making it
+ * an output: the PORT bits stay cleared and the bus needs its external
+ * pull-ups. Pins are accessed through their port registers, 2 cycles
+ * each. The DDR updates are not atomic, interrupts must not change the
+ * direction of other pins of the same ports.
+ */
+class DS7505Pins
+{
+
+public:
+
+  //! The lines on pins \ref sda and \ref scl, clocked at most at \ref hz
+  DS7505Pins(uint8_t sda, uint8_t scl, uint32_t hz = 100000)
+    : _sdaMask(digitalPinToBitMask(sda)), _sclMask(digitalPinToBitMask(scl)),
+      _sdaMode(portModeRegister(digitalPinToPort(sda))), _sclMode(portModeRegister(digitalPinToPort(scl))),
+      _sdaIn(portInputRegister(digitalPinToPort(sda))), _sclIn(portInputRegister(digitalPinToPort(scl)))
+  {
+    *portOutputRegister(digitalPinToPort(sda)) &= ~_sdaMask;
+    *portOutputRegister(digitalPinToPort(scl)) &= ~_sclMask;
+    setFrequency(hz);
+  }
+
+  //! Sets the SCL frequency, the bit-banging overhead comes on top
+  /*!
+   * Above 500 kHz, or at 0, the lines toggle as fast as the CPU goes:
+   * more than the 400 kHz of the DS7505 on fast boards.
+   */
+  void setFrequency(uint32_t hz)
+  {
+    uint32_t half = hz == 0 || hz > 500000 ? 0 : 500000 / hz;
+
+    _halfUs = half > 255 ? 255 : half > 1 ? half - 1 : half;
+  }
+
+  void sdaLow() { *_sdaMode |= _sdaMask; }
+  void sdaRelease() { *_sdaMode &= ~_sdaMask; }
+  bool sda() const { return *_sdaIn & _sdaMask; }
+  void sclLow() { *_sclMode |= _sclMask; }
+  void sclRelease() { *_sclMode &= ~_sclMask; }
+  bool scl() const { return *_sclIn & _sclMask; }
+  void wait() const { if (_halfUs) delayMicroseconds(_halfUs); }
+
+private:
+  uint8_t _sdaMask;
+  uint8_t _sclMask;
+  volatile uint8_t *_sdaMode;
+  volatile uint8_t *_sclMode;
+  volatile uint8_t *_sdaIn;
+  volatile uint8_t *_sclIn;
+  uint8_t _halfUs; // delay of half a period, less the overhead of about 1 us
+};
+#elif defined(DS7505_MAPLE)
+//! Two pins of a Maple board as open drain lines
+class DS7505Pins
+{
+
+public:
+
+  //! The lines on pins \ref sda and \ref scl, clocked at most at \ref hz
+  DS7505Pins(uint8_t sda, uint8_t scl, uint32_t hz = 100000) : _sda(sda), _scl(scl)
+  {
+    digitalWrite(sda, HIGH);
+    digitalWrite(scl, HIGH);
+    pinMode(sda, OUTPUT_OPEN_DRAIN);
+    pinMode(scl, OUTPUT_OPEN_DRAIN);
+    setFrequency(hz);
+  }
+
+  //! Sets the SCL frequency, the bit-banging overhead comes on top
+  void setFrequency(uint32_t hz)
+  {
+    uint32_t half = hz == 0 || hz > 500000 ? 0 : 500000 / hz;
+
+    _halfUs = half > 255 ? 255 : half;
+  }
+
+  void sdaLow() { digitalWrite(_sda, LOW); }
+  void sdaRelease() { digitalWrite(_sda, HIGH); }
+  bool sda() const { return digitalRead(_sda); }
+  void sclLow() { digitalWrite(_scl, LOW); }
+  void sclRelease() { digitalWrite(_scl, HIGH); }
+  bool scl() const { return digitalRead(_scl); }
+  void wait() const { if (_halfUs) delayMicroseconds(_halfUs); }
+
+private:
+  uint8_t _sda;
+  uint8_t _scl;
+  uint8_t _halfUs;
+};
+#endif
+
+#if !defined(DS7505_HOST)
+//! A bit-banged bus on any two pins, see DS7505Transport
+class DS7505SoftWire : public DS7505Transport
+{
+
+public:
+
+  //! A bus on pins \ref sda and \ref scl, clocked at most at \ref hz
+  DS7505SoftWire(uint8_t sda, uint8_t scl, uint32_t hz = 100000) : i2c(DS7505Pins(sda, scl, hz)) {};
+
+  //! The master, to tune its speed or clock stretching limit
+  DS7505SoftI2C<DS7505Pins> i2c;
+
+  //! Releases both lines
+  void begin() { i2c.begin(); }
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n) { return i2c.write(addr, data, n); }
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n) { return i2c.read(addr, data, n); }
+};
+#endif
+
+#endif
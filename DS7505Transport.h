@@ -0,0 +1,61 @@
+#ifndef DS7505_TRANSPORT_H
+#define DS7505_TRANSPORT_H
+
+#include "DS7505.h"
+
+//! A bus of a board other than Wire
+/*!
+ * The driver talks to Wire unless another transport is selected, as it
+ * talks to the selected DS7505Bus on hosts. Each transport keeps the bus
+ * state of its addresses, so every bus may carry sensors at 0x48 to 0x4F.
+ *
+ * \code
+ *
+ *  DS7505SoftWire bus2(4, 5); // SDA on pin 4, SCL on pin 5
+ *  DS7505 a, b;
+ *
+ *  Wire.begin();
+ *  bus2.begin();
+ *  a.init(0, 0, 0, DS7505::RES_12); // on Wire
+ *
+ *  DS7505Transport::select(&bus2);
+ *  b.init(0, 0, 0, DS7505::RES_12); // same address, on pins 4 and 5
+ *  DS7505Transport::select(0);
+ *
+ * \endcode
+ */
+class DS7505Transport
+{
+
+public:
+
+  DS7505Transport() : links() {};
+
+  virtual ~DS7505Transport() {};
+
+  //! Write transaction: start, address + W, \ref n bytes, stop
+  /*!
+   * \return A DS7505::Status
+   */
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n) = 0;
+
+  //! Read transaction: start, address + R, \ref n bytes, stop
+  /*!
+   * \return A DS7505::Status
+   */
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n) = 0;
+
+  //! Bus state of the devices, by address & 0x7
+  DS7505::Link links[8];
+
+  //! Selects the bus the driver talks to, 0 for Wire
+  static void select(DS7505Transport *transport) { _current = transport; }
+
+  //! The bus the driver talks to, 0 for Wire
+  static DS7505Transport *current() { return _current; }
+
+private:
+  static DS7505Transport *_current;
+};
+
+#endif
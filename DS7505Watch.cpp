@@ -0,0 +1,53 @@
+#include "DS7505Watch.h"
+
+//read the temperature and arm the window around it, entering interrupt mode
+uint8_t DS7505Watch::begin(int16_t delta, DS7505::FaultTolerance ft)
+{
+  int16_t raw;
+
+  _delta = delta;
+
+  //the window keeps the resolution and polarity, never a configuration guessed
+  if ((_status = DS7505::refreshConfig(_sensor._i2cAddr, _sensor._configByte)) != DS7505::ST_OK)
+    return _status;
+
+  //no window around a reading that failed
+  if ((_status = _sensor.getRaw(raw)) != DS7505::ST_OK)
+    return _status;
+
+  return _status = arm(raw, ft);
+}
+
+//re-centre once the reading is delta or more off, a failed reading or arming changes nothing
+bool DS7505Watch::update()
+{
+  int16_t raw;
+
+  if ((_status = _sensor.getRaw(raw)) != DS7505::ST_OK)
+    return false;
+
+  int32_t moved = (int32_t) raw - _centre;
+
+  if (moved < _delta && moved > -_delta)
+    return false;
+
+  return (_status = arm(raw, _sensor.config().faultTolerance())) == DS7505::ST_OK;
+}
+
+//TOS trips at centre + delta, THYST below centre - delta + 1 step, in range
+//then the fault tolerance and interrupt mode in one configuration write
+uint8_t DS7505Watch::arm(int16_t raw, DS7505::FaultTolerance ft)
+{
+  DS7505::Config config = _sensor.config().faultTolerance(ft).mode(DS7505::MODE_INTERRUPT);
+  int32_t step = 0x80 >> config.resolution();
+  int32_t tos = (int32_t) raw + _delta;
+  int32_t thyst = (int32_t) raw - _delta + step;
+  uint8_t status;
+
+  if ((status = DS7505::writeRaw(_sensor._i2cAddr, DS7505::P_TOS, (int16_t) (tos > MAX_RAW ? MAX_RAW : tos))) == DS7505::ST_OK
+      && (status = DS7505::writeRaw(_sensor._i2cAddr, DS7505::P_THYST, (int16_t) (thyst < MIN_RAW ? MIN_RAW : thyst))) == DS7505::ST_OK
+      && (status = _sensor.setConfig(config)) == DS7505::ST_OK)
+    _centre = raw;
+
+  return status;
+}
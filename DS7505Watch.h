@@ -0,0 +1,105 @@
+#ifndef DS7505_WATCH_H
+#define DS7505_WATCH_H
+
+#include "DS7505.h"
+
+//! Wake on change: the thermostat of a DS7505 as a change detector
+/*!
+ * begin() reads the temperature and programs TOS/THYST as a window of
+ * +-delta around it, in interrupt mode, so O.S. only fires once the
+ * temperature has moved by delta. update(), called when it fired, reads
+ * the temperature (which releases O.S.) and re-centres the window. Between
+ * changes there is no bus traffic and nothing to wake up for.
+ *
+ * The device only watches one limit at a time in interrupt mode: TOS
+ * after power-up, then THYST once an alert on TOS has been read, then TOS
+ * again and so on. The window catches the first move in either direction
+ * only by chance of the arming, and after an alert the one back, not a
+ * further move the same way. update() is therefore also meant to be
+ * called as a heartbeat, every period a missed change may go unreported:
+ * it re-centres the window whenever the reading is delta or more off.
+ *
+ * \code
+ *
+ *  DS7505 ds7505;
+ *  DS7505Watch watch(ds7505);
+ *  volatile bool fired;
+ *  unsigned long beat;
+ *
+ *  void alert() { fired = true; }
+ *
+ *  ds7505.init(0, 0, 0, DS7505::RES_12);
+ *  watch.begin(DS7505::encodeTemp(0.25f, DS7505::RES_12), DS7505::FT_2);
+ *  attachInterrupt(0, alert, FALLING); // O.S. is active low
+ *
+ *  if (fired || millis() - beat >= 60000) {
+ *    fired = false;
+ *    beat = millis();
+ *    if (watch.update())
+ *      Serial.println(DS7505::decodeTemp(watch.raw()));
+ *  }
+ *
+ * \endcode
+ *
+ * An update() costs a 2 byte read and, on a change, two threshold writes.
+ * The fault tolerance filters out noise around the limits. A window is
+ * only taken as armed once TOS, THYST and the configuration are written:
+ * after a failed write update() reports no change and tries again at the
+ * next call, status() tells why.
+ */
+class DS7505Watch
+{
+
+public:
+
+  //! Watches a sensor, which must have been initialised
+  explicit DS7505Watch(DS7505 &sensor) : _sensor(sensor), _centre(0), _delta(0), _status(DS7505::ST_OK) {};
+
+  //! Starts watching
+  /*!
+   * Keeps the resolution and polarity of the sensor, switches it to
+   * interrupt mode with the given fault tolerance.
+   * \param delta The change to report, a raw code as returned by
+   *   DS7505::encodeTemp() at the resolution of the sensor, one step of
+   *   it at least
+   * \param ft Consecutive conversions past a limit before O.S. fires
+   * \return A DS7505::Status, raw() is the temperature the window is
+   *   centred on when ST_OK. Nothing is armed when the reading failed,
+   *   the sensor stays out of interrupt mode when a write did.
+   */
+  uint8_t begin(int16_t delta, DS7505::FaultTolerance ft = DS7505::FT_1);
+
+  //! Reads the temperature and re-centres the window on a change
+  /*!
+   * To be called once O.S. fired and as a heartbeat. A failed reading
+   * or re-arming leaves the window as it is, see status().
+   * \return Whether the temperature moved by delta or more since the last
+   *   change and the window was re-centred, raw() is then the new
+   *   temperature
+   */
+  bool update();
+
+  //! The DS7505::Status of the last begin() or update(), ST_OK when every transfer succeeded
+  uint8_t status() const { return _status; }
+
+  //! The raw temperature the window is centred on, the last change reported
+  int16_t raw() const { return _centre; }
+
+  //! The change reported, as given to begin()
+  int16_t delta() const { return _delta; }
+
+private:
+  //! The thermostat range, 125 and -55 C
+  static const int16_t MAX_RAW = 125 << 8;
+  static const int16_t MIN_RAW = -55 * 256;
+
+  DS7505 &_sensor;
+  int16_t _centre;
+  int16_t _delta;
+  uint8_t _status;
+
+  //! Centres the window on \ref raw, raw() moves only when it is armed
+  uint8_t arm(int16_t raw, DS7505::FaultTolerance ft);
+};
+
+#endif
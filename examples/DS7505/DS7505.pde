@@ -21,12 +21,12 @@ void setup()
     ds7505.init(0,0,0,DS7505::RES_12);
 
     //set the thermostat at 32.45 (Celsius) with a hysteresis of 30.14 degree
-    ds7505.setThermostatC(32.45f, 30.14f, DS7505::FT_6);
+    DS7505::Thermostat t = ds7505.setThermostatC(32.45f, 30.14f, DS7505::FT_6);
 
-    //the temperatures read back will be slightly off depending on the resolution
+    //the temperatures programmed will be slightly off depending on the resolution
     //settings
-    Serial.println(ds7505.getTempC(DS7505::P_TOS));
-    Serial.println(ds7505.getTempC(DS7505::P_THYST));
+    Serial.println(t.tosC());
+    Serial.println(t.thystC());
 
     //make the settings permanent (write to NV memory)
     ds7505.sendCommand(DS7505::CMD_COPY_DATA);
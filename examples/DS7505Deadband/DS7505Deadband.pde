@@ -0,0 +1,37 @@
+/*
+* DS7505 Library
+* Print the temperature only when it changed, or once a minute
+*/
+#include <Wire.h>
+#include <DS7505.h>
+#include <DS7505Deadband.h>
+
+DS7505 ds7505;
+
+//changes of more than 0.125 degree, a heartbeat every 60 seconds
+DS7505Deadband<1> band(DS7505::encodeTemp(0.125f, DS7505::RES_12), 60);
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Wire.begin();
+
+    ds7505.init(0, 0, 0, DS7505::RES_12);
+}
+
+
+void loop()
+{
+  delay(500);
+
+  int16_t raw = ds7505.getRaw();
+
+  //print the temperature in Celsius and the samples left out since the last one
+  uint16_t skipped = band.channel(0).suppressed;
+  if (band.pass(0, raw, millis() / 1000)) {
+    Serial.print(DS7505::decodeTemp(raw));
+    Serial.print(" ");
+    Serial.println(skipped);
+  }
+}
@@ -0,0 +1,33 @@
+/*
+* DS7505 Library
+* Fixed address and resolution variant
+*/
+#include <Wire.h>
+#include <DS7505.h>
+#include <DS7505Fixed.h>
+
+//the I2C address is 0 0 0 in this case
+//(pin 5, 6, 7 are tied to ground), 12 bit resolution
+DS7505Fixed<0, 0, 0, DS7505::RES_12> ds7505;
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Wire.begin();
+
+    ds7505.init();
+
+    //set the thermostat at 32.45 (Celsius) with a hysteresis of 30.14 degree
+    ds7505.setThermostatC(32.45f, 30.14f, DS7505::FT_6);
+}
+
+
+void loop()
+{
+  //wait for a fresh conversion
+  delay(ds7505.conversionTimeMs());
+
+  //print the current temperature in Fahrenheit
+  Serial.println(ds7505.getTempF());
+}
@@ -0,0 +1,40 @@
+/*
+* DS7505 Library
+* 48 sensors on six buses sharing SCL, read six at a time (AVR boards)
+*/
+#include <Wire.h>
+#include <DS7505.h>
+#include <DS7505Parallel.h>
+
+//SDA lines on digital pins 2 to 7 (bits 2 to 7 of PORTD on an Uno), each
+//with its own 4.7k pull-up and DS7505 at 0x48 to 0x4F, SCL on digital pin 8
+DS7505Parallel<DS7505PortPins> grid(DS7505PortPins(2, 0xFC, 8, 400000), 0xFC);
+
+int16_t raw[8][8];
+uint8_t read[8];
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Serial.print(grid.init(0xFF, DS7505::RES_11));
+    Serial.println(" sensors");
+}
+
+
+void loop()
+{
+  delay(grid.conversionTimeMs());
+  grid.sweep(raw, read);
+
+  for (uint8_t a = 0; a < 8; a++) {
+    for (uint8_t i = 2; i < 8; i++) {
+      if (read[a] & 1 << i)
+        Serial.print(DS7505::decodeTemp(raw[a][i]));
+      else
+        Serial.print("-");
+      Serial.print(" ");
+    }
+    Serial.println();
+  }
+}
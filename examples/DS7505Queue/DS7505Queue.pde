@@ -0,0 +1,52 @@
+/*
+* DS7505 Library
+* Eight sensors read in the background while the loop keeps blinking
+*
+* With DS7505_TWI_QUEUE defined in DS7505.h the reads run from the TWI
+* interrupt: leave out #include <Wire.h> and Wire.begin(). Without it
+* they run from queue.poll() on Wire.
+*/
+#include <Wire.h>
+#include <DS7505.h>
+#include <DS7505Array.h>
+#include <DS7505Queue.h>
+
+DS7505Queue queue;
+DS7505Array sensors;
+DS7505Sweep sweep;
+unsigned long last;
+
+void setup()
+{
+    Serial.begin(9600);
+    pinMode(13, OUTPUT);
+
+    Wire.begin();
+    queue.begin(400000);
+
+    //sensors at 0x48 to 0x4F, the driver's calls wait in the queue
+    sensors.init(0xFF, DS7505::RES_12);
+    sweep.start(queue, sensors.mask());
+    last = millis();
+}
+
+
+void loop()
+{
+  digitalWrite(13, millis() / 250 & 1);
+  queue.poll();
+
+  if (sweep.done() && millis() - last >= sensors.conversionTimeMs()) {
+    for (uint8_t i = 0; i < 8; i++) {
+      if (sweep.read & 1 << i)
+        Serial.print(DS7505::decodeTemp(sweep.raw[i]));
+      else
+        Serial.print("-");
+      Serial.print(" ");
+    }
+    Serial.println();
+
+    last = millis();
+    sweep.start(queue, sensors.mask());
+  }
+}
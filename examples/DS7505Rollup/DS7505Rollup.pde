@@ -0,0 +1,44 @@
+/*
+* DS7505 Library
+* Rolling minimum / maximum / mean of the last day
+*/
+#include <Wire.h>
+#include <DS7505.h>
+#include <DS7505Rollup.h>
+
+DS7505 ds7505;
+
+//last 10 seconds, 15 minutes and 24 hours (about 520 bytes on AVR)
+DS7505Rollup<10, 15, 24> history;
+uint32_t printed;
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Wire.begin();
+
+    ds7505.init(0, 0, 0, DS7505::RES_12);
+}
+
+
+void loop()
+{
+  //wait for a fresh conversion
+  delay(DS7505::conversionTimeMs(DS7505::RES_12));
+
+  uint32_t now = millis() / 1000;
+  history.add(now, ds7505.getRaw());
+
+  //every minute, print the extremes and the mean of the last hour
+  if (now - printed >= 60) {
+    printed = now;
+    DS7505Rollup<10, 15, 24>::Bucket hour = history.query(now - 3599, now);
+
+    Serial.print(DS7505::decodeTemp(hour.min));
+    Serial.print(" ");
+    Serial.print(DS7505::decodeTemp(hour.max));
+    Serial.print(" ");
+    Serial.println(hour.mean() / 256);
+  }
+}
@@ -0,0 +1,45 @@
+/*
+* DS7505 Library
+* Two sensors sampled at 4 Hz, two once a minute, on one bus
+*/
+#include <Wire.h>
+#include <DS7505.h>
+#include <DS7505Array.h>
+#include <DS7505Scheduler.h>
+
+DS7505Array sensors;
+DS7505Scheduler scheduler(sensors);
+int16_t raw[8];
+
+void setup()
+{
+    Serial.begin(9600);
+    Wire.begin();
+
+    //sensors at 0 0 0 to 0 1 1
+    sensors.init(0x0F, DS7505::RES_12);
+    scheduler.add(0, 250, DS7505::RES_11, millis());
+    scheduler.add(1, 250, DS7505::RES_11, millis());
+    scheduler.add(2, 60000, DS7505::RES_12, millis());
+    scheduler.add(3, 60000, DS7505::RES_12, millis());
+
+    //a minute sample may come up to 20 ms early to share a 4 Hz sweep
+    scheduler.window = 20;
+}
+
+
+void loop()
+{
+  uint8_t read = scheduler.run(millis(), raw);
+
+  for (uint8_t i = 0; i < 4; i++) {
+    if (read & 1 << i) {
+      Serial.print(i, DEC);
+      Serial.print(" ");
+      Serial.println(DS7505::decodeTemp(raw[i]));
+    }
+  }
+
+  if (scheduler.misses(0) || scheduler.misses(1))
+    Serial.println("4 Hz deadline missed");
+}
@@ -0,0 +1,41 @@
+/*
+* DS7505 Library
+* Two sensors at the same address, one on Wire, one bit-banged on pins 4 and 5
+*/
+#include <Wire.h>
+#include <DS7505.h>
+#include <DS7505SoftI2C.h>
+
+//SDA on digital pin 4, SCL on digital pin 5, 4.7k pull-ups to VCC
+DS7505SoftWire bus2(4, 5, 100000);
+
+DS7505 inside;
+DS7505 outside;
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Wire.begin();
+    bus2.begin();
+
+    inside.init(0, 0, 0, DS7505::RES_12);
+
+    //the driver talks to the selected bus, Wire when none is
+    DS7505Transport::select(&bus2);
+    outside.init(0, 0, 0, DS7505::RES_12);
+    DS7505Transport::select(0);
+}
+
+
+void loop()
+{
+  delay(DS7505::conversionTimeMs(DS7505::RES_12));
+
+  Serial.print(inside.getTempC());
+  Serial.print(" ");
+
+  DS7505Transport::select(&bus2);
+  Serial.println(outside.getTempC());
+  DS7505Transport::select(0);
+}
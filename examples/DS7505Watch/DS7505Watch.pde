@@ -0,0 +1,49 @@
+/*
+* DS7505 Library
+* Report every quarter degree change, waking up on the O.S. output
+*/
+#include <Wire.h>
+#include <DS7505.h>
+#include <DS7505Watch.h>
+
+DS7505 ds7505;
+DS7505Watch watch(ds7505);
+
+//O.S. wired to digital pin 2 (interrupt 0), with a pull-up
+volatile bool fired;
+unsigned long beat;
+
+void alert()
+{
+  fired = true;
+}
+
+void setup()
+{
+    Serial.begin(9600);
+
+    Wire.begin();
+
+    ds7505.init(0, 0, 0, DS7505::RES_12);
+
+    //two conversions in a row past a limit before O.S. fires
+    watch.begin(DS7505::encodeTemp(0.25f, DS7505::RES_12), DS7505::FT_2);
+    Serial.println(DS7505::decodeTemp(watch.raw()));
+
+    pinMode(2, INPUT);
+    digitalWrite(2, HIGH);
+    attachInterrupt(0, alert, FALLING);
+}
+
+
+void loop()
+{
+  //the heartbeat catches the changes the armed limit misses
+  if (fired || millis() - beat >= 60000) {
+    fired = false;
+    beat = millis();
+
+    if (watch.update())
+      Serial.println(DS7505::decodeTemp(watch.raw()));
+  }
+}
@@ -0,0 +1,132 @@
+/*
+ * Sensor tasks multiplexed on one thread with the coroutine API
+ *
+ *   g++ -std=c++20 -O2 -pthread -I. -Iextras/host extras/bench/async.cpp \
+ *       DS7505.cpp DS7505Array.cpp extras/host/DS7505Bus.cpp \
+ *       extras/host/DS7505Sim.cpp extras/host/DS7505Async.cpp -o async
+ *   ./async [sensors] [reads]
+ *
+ * Every sensor has a task that configures it, then waits a conversion
+ * and reads it \ref reads times; a task per bus of eight sweeps it as
+ * often. The simulated buses run inline, then on bus threads as i2c-dev
+ * would, then inline again on a virtual clock shared by the loop and the
+ * simulated devices, where the conversion waits take no time. Reported:
+ * reads per second of wall time, the CPU they cost and the memory of
+ * every pending operation, which is all in coroutine frames.
+ */
+#include "bench.h"
+#include <DS7505Async.h>
+#include <DS7505Sim.h>
+#include <memory>
+#include <stdlib.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+
+static unsigned long reads, errors;
+static size_t peak;
+
+static DS7505Task<void> poll(DS7505AsyncSensor &sensor, DS7505Sim &sim, uint8_t i, unsigned n)
+{
+  co_await sensor.init(i >> 2 & 1, i >> 1 & 1, i & 1, DS7505::RES_09);
+  co_await sensor.setThermostat(30, 25);
+
+  for (unsigned k = 0; k < n; k++) {
+    co_await sensor.conversion();
+    peak = std::max(peak, DS7505Frame::allocated);
+    errors += co_await sensor.readRaw() != sim.raw(DS7505::P_TEMP);
+    reads++;
+  }
+}
+
+static DS7505Task<void> sweep(DS7505AsyncBus &bus, DS7505Array &array, unsigned n)
+{
+  int16_t raw[8];
+
+  co_await bus.call([&array] { return array.init(0xFF, DS7505::RES_09); });
+
+  for (unsigned k = 0; k < n; k++) {
+    co_await bus.loop().sleep(array.conversionTimeMs() * 1000000ull);
+    peak = std::max(peak, DS7505Frame::allocated);
+    reads += __builtin_popcount(co_await bus.sweep(array, raw));
+  }
+}
+
+static double cpuSeconds()
+{
+  struct rusage ru;
+
+  getrusage(RUSAGE_SELF, &ru);
+
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned sensors = argc > 1 ? atoi(argv[1]) : 4096;
+  unsigned n = argc > 2 ? atoi(argv[2]) : 20;
+  unsigned buses = (sensors + 7) / 8;
+
+  prctl(PR_SET_TIMERSLACK, 1000ul);
+  printf("[\n");
+
+  for (int mode = 0; mode < 4; mode++) {
+    bool threaded = mode == 2;
+    DS7505VirtualClock virtualClock;
+    DS7505Clock &clock = mode == 3 ? virtualClock : DS7505Clock::real();
+    DS7505Loop loop(clock);
+    std::vector<std::unique_ptr<DS7505SimBus> > simBuses;
+    std::vector<std::unique_ptr<DS7505Sim[]> > sims;
+    std::vector<std::unique_ptr<DS7505AsyncBus> > asyncBuses;
+    std::vector<std::unique_ptr<DS7505AsyncSensor> > tasks;
+    std::vector<std::unique_ptr<DS7505Array> > arrays;
+    // bus threads cost a stack each, keep their count sane
+    unsigned count = threaded ? std::min(buses, 64u) : buses;
+
+    for (unsigned b = 0; b < count; b++) {
+      simBuses.emplace_back(new DS7505SimBus());
+      simBuses[b]->clock = &clock;
+      sims.emplace_back(new DS7505Sim[8]);
+      for (uint8_t i = 0; i < 8; i++) {
+        sims[b][i].setTemp(20 + b % 50 + i / 8.0);
+        simBuses[b]->attach(0x48 | i, &sims[b][i]);
+      }
+      asyncBuses.emplace_back(new DS7505AsyncBus(loop, *simBuses[b], threaded));
+    }
+
+    reads = errors = peak = 0;
+    size_t base = DS7505Frame::allocated;
+    unsigned spawned = 0;
+
+    for (unsigned b = 0; b < count; b++) {
+      if (mode == 1) {
+        arrays.emplace_back(new DS7505Array());
+        loop.spawn(sweep(*asyncBuses[b], *arrays.back(), n));
+        spawned++;
+        continue;
+      }
+      for (uint8_t i = 0; i < 8 && b * 8 + i < sensors; i++) {
+        tasks.emplace_back(new DS7505AsyncSensor(*asyncBuses[b]));
+        loop.spawn(poll(*tasks.back(), sims[b][i], i, n));
+        spawned++;
+      }
+    }
+
+    double cpu = cpuSeconds();
+    double start = benchNow();
+    uint64_t virtualStart = clock.now();
+    loop.run();
+    double seconds = (benchNow() - start) / 1e9;
+    cpu = cpuSeconds() - cpu;
+
+    static const char *NAMES[] = { "tasks_inline", "sweeps_inline", "tasks_threaded", "tasks_virtual" };
+    printf("  {\"name\": \"%s\", \"tasks\": %u, \"buses\": %u, \"reads\": %lu, \"errors\": %lu, "
+           "\"clock_s\": %.3f, \"wall_s\": %.3f, \"reads_per_s\": %.0f, \"cpu_us_per_read\": %.2f, "
+           "\"bytes_per_pending_op\": %.1f, \"bytes_per_sensor_object\": %zu}%s\n",
+           NAMES[mode], spawned, count, reads, errors, (clock.now() - virtualStart) / 1e9, seconds,
+           reads / seconds, cpu * 1e6 / reads, (double) (peak - base) / spawned,
+           sizeof(DS7505AsyncSensor), mode < 3 ? "," : "");
+  }
+  printf("]\n");
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Bulk raw code conversion: bit-exactness and throughput of each kernel
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/batch.cpp \
+ *       extras/host/DS7505Batch.cpp -o batch
+ *   ./batch [samples...]
+ *
+ * Every kernel is first checked against the scalar codec on all 65536
+ * codes, then timed on 10^6, 10^7 and 10^8 samples (or the given counts).
+ * Throughput counts the bytes read and written (6 per sample).
+ */
+#include "bench.h"
+#include <DS7505Batch.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static bool exact(DS7505Batch::Kernel kernel, DS7505Batch::Unit unit)
+{
+  std::vector<int16_t> raw(65536 + 7);
+  std::vector<float> ref(raw.size()), out(raw.size());
+
+  // + 7 codes so the scalar tail is exercised too
+  for (size_t i = 0; i < raw.size(); i++)
+    raw[i] = (int16_t) (i - 32768);
+
+  DS7505Batch::convertRaw(raw.data(), ref.data(), raw.size(), unit, DS7505Batch::K_SCALAR);
+  DS7505Batch::convertRaw(raw.data(), out.data(), raw.size(), unit, kernel);
+
+  return memcmp(ref.data(), out.data(), ref.size() * sizeof(float)) == 0;
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<size_t> sizes;
+  bool first = true;
+
+  for (int i = 1; i < argc; i++)
+    sizes.push_back(strtoul(argv[i], 0, 10));
+  if (sizes.empty()) {
+    sizes.push_back(1000000);
+    sizes.push_back(10000000);
+    sizes.push_back(100000000);
+  }
+
+  printf("[\n");
+
+  for (int k = DS7505Batch::K_SCALAR; k <= DS7505Batch::K_NEON; k++) {
+    DS7505Batch::Kernel kernel = (DS7505Batch::Kernel) k;
+
+    if (!DS7505Batch::supported(kernel))
+      continue;
+
+    for (int u = DS7505Batch::UNIT_C; u <= DS7505Batch::UNIT_F; u++) {
+      DS7505Batch::Unit unit = (DS7505Batch::Unit) u;
+      bool ok = exact(kernel, unit);
+
+      for (size_t s = 0; s < sizes.size(); s++) {
+        size_t n = sizes[s];
+        std::vector<int16_t> raw(n);
+        std::vector<float> out(n);
+
+        for (size_t i = 0; i < n; i++)
+          raw[i] = (int16_t) ((i * 2654435761u >> 16) & 0xFFF0);
+
+        double ns = benchNsPerOp(n, [&] {
+          DS7505Batch::convertRaw(raw.data(), out.data(), n, unit, kernel);
+          benchKeep(out);
+        }, n >= 100000000 ? 3 : 7);
+
+        printf("%s  {\"kernel\": \"%s\", \"unit\": \"%s\", \"samples\": %zu, \"bit_exact\": %s, "
+               "\"ns_per_sample\": %.4f, \"gb_per_s\": %.2f, \"best\": %s}",
+               first ? "" : ",\n", DS7505Batch::name(kernel), unit == DS7505Batch::UNIT_C ? "C" : "F",
+               n, ok ? "true" : "false", ns, 6 / ns,
+               kernel == DS7505Batch::best() ? "true" : "false");
+        first = false;
+      }
+    }
+  }
+
+  printf("\n]\n");
+
+  return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef DS7505_BENCH_H
+#define DS7505_BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+
+//! Monotonic time in nanoseconds
+inline double benchNow()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+//! Best ns per operation of a few timed rounds
+/*!
+ * \param ops Operations run by one call of \ref f
+ * \param f The work, called once per round
+ */
+template <typename F>
+double benchNsPerOp(unsigned long ops, F f, int rounds = 7)
+{
+  double best = 0;
+
+  for (int r = 0; r < rounds; r++) {
+    double start = benchNow();
+    f();
+    double ns = (benchNow() - start) / ops;
+
+    if (r == 0 || ns < best)
+      best = ns;
+  }
+
+  return best;
+}
+
+//! Keeps the compiler from optimising a result away
+template <typename T>
+inline void benchKeep(const T &v)
+{
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+#endif
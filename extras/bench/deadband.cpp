@@ -0,0 +1,100 @@
+/*
+ * Change-only reporting of simulated rooms through DS7505Deadband
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/deadband.cpp DS7505.cpp \
+ *       DS7505Array.cpp extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp -o deadband
+ *   ./deadband [hours] [heartbeat_s]
+ *
+ * Eight rooms on one simulated bus (drift, a heater once an hour, a step
+ * event, noise), swept at every 12 bit conversion in virtual time. The
+ * sweeps are filtered at deadbands of 0 to 8 steps: for each, the share
+ * of the samples reported, the largest error of the last report against
+ * the samples suppressed, and the filter cost per sample.
+ */
+#include "bench.h"
+#include <DS7505Array.h>
+#include <DS7505Deadband.h>
+#include <DS7505Sim.h>
+#include <stdlib.h>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+  double hours = argc > 1 ? atof(argv[1]) : 24;
+  unsigned heartbeat = argc > 2 ? atoi(argv[2]) : 60;
+  DS7505VirtualClock clock;
+  DS7505SimBus bus;
+  DS7505Sim sims[8];
+  DS7505Plant plants[8];
+  DS7505Array array;
+  std::vector<int16_t> samples; // 8 per sweep
+  std::vector<uint16_t> times;
+
+  srand(1);
+  for (uint8_t i = 0; i < 8; i++) {
+    DS7505Plant &p = plants[i];
+
+    p = DS7505Plant(18 + rand() % 800 / 100.0f, 300 + rand() % 1200, i + 1);
+    p.drift = 1.5f;
+    p.noise = 0.03f;
+    for (float h = rand() % 3600; h < hours * 3600; h += 3600)
+      p.addSource(h, h + 600, 2 + rand() % 4);
+    p.addStep(rand() % (unsigned) (hours * 3600 + 1), rand() % 2 ? 3.0f : -3.0f);
+    sims[i].setPlant(&p);
+    bus.attach(0x48 | i, &sims[i]);
+  }
+
+  bus.clock = &clock;
+  DS7505Bus::select(&bus);
+  array.init(0xFF, DS7505::RES_12);
+
+  uint64_t end = (uint64_t) (hours * 3600e9);
+  while (clock.now() + array.conversionTimeMs() * 1000000ull <= end) {
+    int16_t raw[8];
+
+    array.waitConversion();
+    if (array.sweep(raw) != 0xFF)
+      return 1;
+    samples.insert(samples.end(), raw, raw + 8);
+    times.push_back((uint16_t) (clock.now() / 1000000000ull));
+  }
+
+  size_t sweeps = times.size();
+  int16_t step = DS7505::encodeTemp(0.0625f, DS7505::RES_12);
+
+  printf("[");
+  for (int steps = 0; steps <= 8; steps = steps ? steps * 2 : 1) {
+    DS7505Deadband<8> band(steps * step, heartbeat);
+    int16_t last[8];
+    int16_t maxError = 0;
+
+    for (size_t s = 0; s < sweeps; s++) {
+      const int16_t *raw = &samples[s * 8];
+      uint8_t report = band.filter(0xFF, raw, times[s]);
+
+      for (uint8_t i = 0; i < 8; i++) {
+        if (report & 1 << i)
+          last[i] = raw[i];
+        else if (abs(raw[i] - last[i]) > maxError)
+          maxError = abs(raw[i] - last[i]);
+      }
+    }
+
+    double ns = benchNsPerOp(sweeps * 8, [&] {
+      DS7505Deadband<8> b(steps * step, heartbeat);
+
+      for (size_t s = 0; s < sweeps; s++)
+        benchKeep(b.filter(0xFF, &samples[s * 8], times[s]));
+    }, 3);
+
+    printf("%s\n  {\"deadband_c\": %.4f, \"heartbeat_s\": %u, \"samples\": %lu, \"reported\": %lu, "
+           "\"reported_pct\": %.3f, \"max_error_c\": %.4f, \"ns_per_sample\": %.2f, \"bytes_per_sensor\": %zu}",
+           steps ? "," : "", DS7505::decodeTemp(steps * step), heartbeat,
+           (unsigned long) (band.reported + band.suppressed), (unsigned long) band.reported,
+           100.0 * band.reported / (band.reported + band.suppressed), DS7505::decodeTemp(maxError), ns,
+           sizeof(DS7505Deadband<8>::Channel));
+  }
+  printf("\n]\n");
+
+  return 0;
+}
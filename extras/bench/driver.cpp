@@ -0,0 +1,123 @@
+/*
+ * Host benchmarks of the codec and of full read paths on the simulated bus
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/driver.cpp DS7505.cpp \
+ *       extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp -o driver
+ *   ./driver > bench.json
+ *
+ * Every result is one JSON object per line of a JSON array:
+ *   {"name": ..., "ns_per_op": ..., "transactions_per_op": ...}
+ * scripts/bench-compare.py diffs two such files.
+ */
+#include "bench.h"
+#include <DS7505Sim.h>
+#include <vector>
+
+static const unsigned long CODES = 1 << 16;
+
+static bool first = true;
+
+static void report(const char *name, double ns, double transactions)
+{
+  printf("%s  {\"name\": \"%s\", \"ns_per_op\": %.3f, \"transactions_per_op\": %.3f}",
+         first ? "[\n" : ",\n", name, ns, transactions);
+  first = false;
+}
+
+static void codec()
+{
+  std::vector<int16_t> raws(CODES);
+  std::vector<float> temps(CODES);
+
+  for (unsigned long i = 0; i < CODES; i++) {
+    raws[i] = (int16_t) ((-55 * 256 + (int) (i * 45 % (180 * 256))) & ~0xF);
+    temps[i] = -55.0f + 180.0f * i / CODES;
+  }
+
+  report("decodeTemp", benchNsPerOp(CODES, [&] {
+    for (unsigned long i = 0; i < CODES; i++)
+      temps[i] = DS7505::decodeTemp(raws[i]);
+    benchKeep(temps);
+  }), 0);
+
+  report("encodeTemp", benchNsPerOp(CODES, [&] {
+    for (unsigned long i = 0; i < CODES; i++)
+      raws[i] = DS7505::encodeTemp(temps[i], DS7505::RES_12);
+    benchKeep(raws);
+  }), 0);
+
+  report("toFahrenheit", benchNsPerOp(CODES, [&] {
+    for (unsigned long i = 0; i < CODES; i++)
+      temps[i] = DS7505::toFahrenheit(temps[i]);
+    benchKeep(temps);
+  }), 0);
+
+  report("toCelsius", benchNsPerOp(CODES, [&] {
+    for (unsigned long i = 0; i < CODES; i++)
+      temps[i] = DS7505::toCelsius(temps[i]);
+    benchKeep(temps);
+  }), 0);
+}
+
+static void thermostat()
+{
+  DS7505SimBus bus;
+  DS7505Sim sim;
+  DS7505 sensor;
+  const unsigned long ops = 10000;
+
+  bus.attach(0x48, &sim);
+  DS7505Bus::select(&bus);
+  sensor.init(0, 0, 0, DS7505::RES_12);
+
+  unsigned long before = bus.transactions;
+  double ns = benchNsPerOp(ops, [&] {
+    for (unsigned long i = 0; i < ops; i++)
+      sensor.setThermostatC(30.0f + (i & 7), 25.0f, DS7505::FT_1);
+  }, 1);
+
+  report("setThermostatC", ns, (double) (bus.transactions - before) / ops);
+}
+
+static void sweeps(uint8_t count)
+{
+  static const char *resNames[] = { "RES_09", "RES_10", "RES_11", "RES_12" };
+  const unsigned long ops = 20000;
+
+  for (int res = DS7505::RES_09; res <= DS7505::RES_12; res++) {
+    DS7505SimBus bus;
+    DS7505Sim sims[8];
+    DS7505 sensors[8];
+    char name[64];
+
+    DS7505Bus::select(&bus);
+    for (uint8_t i = 0; i < count; i++) {
+      bus.attach(0x48 | i, &sims[i]);
+      sims[i].setTemp(21.3f + i);
+      sensors[i].init(i >> 2 & 1, i >> 1 & 1, i & 1, (DS7505::Resolution) res);
+    }
+
+    unsigned long before = bus.transactions;
+    float sum = 0;
+    double ns = benchNsPerOp(ops, [&] {
+      for (unsigned long s = 0; s < ops; s++)
+        for (uint8_t i = 0; i < count; i++)
+          sum += sensors[i].getTempC();
+    }, 1);
+    benchKeep(sum);
+
+    snprintf(name, sizeof(name), "sweep_%u_%s", count, resNames[res]);
+    report(name, ns, (double) (bus.transactions - before) / ops);
+  }
+}
+
+int main()
+{
+  codec();
+  thermostat();
+  sweeps(1);
+  sweeps(8);
+  printf("\n]\n");
+
+  return 0;
+}
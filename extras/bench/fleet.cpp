@@ -0,0 +1,116 @@
+/*
+ * Fleet of simulated DS7505 read through the driver in virtual time
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/fleet.cpp DS7505.cpp \
+ *       DS7505Array.cpp extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp -o fleet
+ *   ./fleet [sensors] [hours] [bits]
+ *
+ * Sensors sit eight to a bus, each in a room of its own: ambient 18 to
+ * 26 C, a daily drift, a heater switched on once an hour for ten minutes,
+ * a random step event and measurement noise. Every bus shares one
+ * DS7505VirtualClock: the gateway loop waits a conversion with
+ * DS7505Array::waitConversion(), which only moves virtual time, and
+ * sweeps every bus through DS7505Array.
+ *
+ * The driver time (sweeps, bus and register model included) and the plant
+ * time are reported apart, with the sensors one core could sustain at
+ * that conversion period.
+ */
+#include "bench.h"
+#include <DS7505Array.h>
+#include <DS7505Sim.h>
+#include <math.h>
+#include <memory>
+#include <stdlib.h>
+#include <vector>
+
+struct Bus
+{
+  DS7505SimBus bus;
+  DS7505Sim sims[8];
+  DS7505Plant plants[8];
+  DS7505Array array;
+};
+
+int main(int argc, char **argv)
+{
+  unsigned sensors = argc > 1 ? atoi(argv[1]) : 10000;
+  double hours = argc > 2 ? atof(argv[2]) : 1;
+  unsigned bits = argc > 3 ? atoi(argv[3]) : 12;
+  DS7505::Resolution res = (DS7505::Resolution) (bits - 9);
+  unsigned buses = (sensors + 7) / 8;
+  std::vector<std::unique_ptr<Bus> > fleet;
+  DS7505VirtualClock clock;
+  uint64_t end = (uint64_t) (hours * 3600e9);
+
+  srand(1);
+  for (unsigned b = 0; b < buses; b++) {
+    Bus *f = new Bus();
+    uint8_t mask = 0;
+
+    for (uint8_t i = 0; i < 8 && b * 8 + i < sensors; i++) {
+      DS7505Plant &p = f->plants[i];
+      float hour = (float) (rand() % 3600);
+
+      p = DS7505Plant(18 + rand() % 800 / 100.0f, 300 + rand() % 1200, b * 8 + i + 1);
+      p.drift = 1.5f;
+      p.noise = 0.03f;
+      for (float h = hour; h < hours * 3600; h += 3600)
+        p.addSource(h, h + 600, 2 + rand() % 4);
+      p.addStep((float) (rand() % (unsigned) (hours * 3600 + 1)), rand() % 2 ? 3.0f : -3.0f);
+
+      f->sims[i].setPlant(&p);
+      f->bus.attach(0x48 | i, &f->sims[i]);
+      mask |= 1 << i;
+    }
+
+    f->bus.clock = &clock;
+    DS7505Bus::select(&f->bus);
+    f->array.init(mask, res);
+    fleet.push_back(std::unique_ptr<Bus>(f));
+  }
+
+  uint64_t period = DS7505::conversionTimeMs(res) * 1000000ull;
+  unsigned long samples = 0, missing = 0;
+  double driverNs = 0, plantNs = 0, sum = 0;
+  double wall = benchNow();
+
+  while (clock.now() + period <= end) {
+    fleet[0]->array.waitConversion();
+
+    // the buses tick their devices lazily, do it up front to time the plants apart
+    double start = benchNow();
+    for (unsigned b = 0; b < buses; b++)
+      for (uint8_t i = 0; i < 8; i++)
+        fleet[b]->sims[i].tick(clock.now() / 1000);
+    double swept = benchNow();
+    plantNs += swept - start;
+
+    for (unsigned b = 0; b < buses; b++) {
+      int16_t raw[8];
+      Bus &f = *fleet[b];
+
+      DS7505Bus::select(&f.bus);
+      uint8_t read = f.array.sweep(raw);
+
+      samples += __builtin_popcount(read);
+      missing += __builtin_popcount(f.array.mask() & ~read);
+      for (uint8_t i = 0; i < 8; i++)
+        if (read & 1 << i)
+          sum += raw[i];
+    }
+    driverNs += benchNow() - swept;
+  }
+
+  wall = (benchNow() - wall) / 1e9;
+
+  double perSample = driverNs / samples;
+  printf("{\"sensors\": %u, \"buses\": %u, \"bits\": %u, \"virtual_s\": %.0f, \"wall_s\": %.2f, "
+         "\"speedup\": %.0f, \"samples\": %lu, \"missing\": %lu, \"mean_celsius\": %.3f, "
+         "\"driver_ns_per_sample\": %.1f, \"plant_ns_per_sample\": %.1f, "
+         "\"sensors_per_core\": %.0f}\n",
+         sensors, buses, bits, clock.now() / 1e9, wall, clock.now() / 1e9 / wall, samples, missing,
+         samples ? sum / samples / 256 : 0, perSample, plantNs / samples, period / perSample);
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Resolution gained by DS7505::oversample() against the time it takes
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/oversample.cpp DS7505.cpp \
+ *       extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp -o oversample
+ *   ./oversample [noise] [trials]
+ *
+ * A simulated sensor measures a room held at random temperatures around
+ * 21 C with gaussian noise (0.05 C by default) in virtual time. For each
+ * resolution and k = 0 to 8, trials oversampled readings are taken: the
+ * RMS error of the mean against the true temperature, the effective
+ * resolution it amounts to (log2 of the 12 bit step over the error, plus
+ * 12), the noise estimated against the noise set, and the readings per
+ * second. Without noise (first argument 0) the mean stays on a step and
+ * nothing is gained.
+ */
+#include "bench.h"
+#include <DS7505Sim.h>
+#include <math.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+  float noise = argc > 1 ? atof(argv[1]) : 0.05f;
+  unsigned trials = argc > 2 ? atoi(argv[2]) : 64;
+  DS7505VirtualClock clock;
+  DS7505SimBus bus;
+  DS7505Sim sim;
+  DS7505 sensor;
+
+  bus.attach(0x48, &sim);
+  bus.clock = &clock;
+  DS7505Bus::select(&bus);
+
+  srand(1);
+  printf("[");
+  for (unsigned bits = 9; bits <= 12; bits++) {
+    DS7505::Resolution res = (DS7505::Resolution) (bits - 9);
+
+    sensor.init(0, 0, 0, res);
+    for (uint8_t k = 0; k <= 8; k++) {
+      double squares = 0, estimated = 0;
+      uint64_t start = clock.now();
+
+      for (unsigned t = 0; t < trials; t++) {
+        // a fresh plant at a temperature off the steps
+        DS7505Plant room(21.0f + rand() % 1000 / 1000.0f, 600.0f, t + 1);
+        room.noise = noise;
+        sim.setPlant(&room);
+
+        DS7505::Oversample o = sensor.oversample(k);
+        double e = o.celsius() - room.temp(clock.now() / 1000);
+
+        squares += e * e;
+        estimated += o.noise();
+        sim.setPlant(0);
+      }
+
+      double rms = sqrt(squares / trials);
+      double seconds = (clock.now() - start) / 1e9 / trials;
+
+      printf("%s\n  {\"bits\": %u, \"k\": %u, \"noise_c\": %.3f, \"rms_error_c\": %.5f, "
+             "\"effective_bits\": %.2f, \"noise_estimate_c\": %.4f, \"seconds_per_reading\": %.3f, "
+             "\"readings_per_s\": %.3f}",
+             bits == 9 && k == 0 ? "" : ",", bits, k, noise, rms,
+             rms > 0 ? 12 + log2(0.0625 / rms) : 99.0, estimated / trials, seconds, 1 / seconds);
+    }
+  }
+  printf("\n]\n");
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Port-parallel reads of an 8 x 8 DS7505 array on the pin-level simulator
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/parallel.cpp DS7505.cpp \
+ *       extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp extras/host/DS7505PinSim.cpp -o parallel
+ *   ./parallel [op_ns] [sweeps]
+ *
+ * Eight SDA lines share SCL, each with a DS7505 at every address 0x48 to
+ * 0x4F. A sweep reads the 64 temperatures, either with DS7505Parallel (8
+ * reads clocking every lane at once) or serially with one DS7505SoftI2C
+ * per lane (64 reads), the pointers already at P_TEMP in both cases. Each
+ * pin access costs op_ns (125 ns by default). For each SCL frequency and
+ * method: the virtual bus time per sweep and per sensor, the SCL clocks
+ * per sweep, the host CPU per sweep and the samples that did not match
+ * the register model.
+ */
+#include "bench.h"
+#include <DS7505PinSim.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+  unsigned opNs = argc > 1 ? atoi(argv[1]) : 125;
+  unsigned sweeps = argc > 2 ? atoi(argv[2]) : 200;
+  static const uint32_t speeds[] = { 100000, 400000, 0 };
+
+  printf("[");
+  for (unsigned s = 0; s < 3; s++) {
+    for (unsigned parallel = 0; parallel < 2; parallel++) {
+      DS7505VirtualClock clock;
+      DS7505PinSim wire;
+      static DS7505Sim sims[8][8];
+      DS7505Parallel<DS7505SimPortPins> grid(DS7505SimPortPins(wire, speeds[s]), 0xFF);
+      int16_t raw[8][8];
+      uint8_t read[8];
+      unsigned errors = 0;
+
+      wire.clock = &clock;
+      wire.opNs = opNs;
+      for (uint8_t a = 0; a < 8; a++)
+        for (uint8_t i = 0; i < 8; i++)
+          wire.lanes[i].attach(0x48 | a, &sims[a][i]);
+
+      if (grid.init(0xFF, DS7505::RES_12) != 64) {
+        printf("init failed\n");
+        return 1;
+      }
+      grid.sweep(raw, read); // points at P_TEMP from now on
+
+      uint64_t start = clock.now();
+      unsigned long clocks = wire.clocks;
+      double wall = benchNow();
+
+      for (unsigned n = 0; n < sweeps; n++) {
+        for (uint8_t a = 0; a < 8; a++)
+          for (uint8_t i = 0; i < 8; i++)
+            sims[a][i].setTemp(20 + ((n + a * 8 + i) % 256) * 0.0625f);
+
+        if (parallel) {
+          grid.sweep(raw, read);
+        } else {
+          for (uint8_t i = 0; i < 8; i++) {
+            DS7505SoftI2C<DS7505SimPins> lane(DS7505SimPins(wire, speeds[s], i));
+
+            for (uint8_t a = 0; a < 8; a++) {
+              uint8_t b[2];
+
+              if (lane.read(0x48 | a, b, 2) == DS7505::ST_OK)
+                read[a] |= 1 << i;
+              else
+                read[a] &= ~(1 << i);
+              raw[a][i] = (int16_t) ((uint16_t) b[0] << 8 | b[1]);
+            }
+          }
+        }
+
+        for (uint8_t a = 0; a < 8; a++)
+          for (uint8_t i = 0; i < 8; i++)
+            if (!(read[a] & 1 << i) || raw[a][i] != sims[a][i].raw(DS7505::P_TEMP))
+              errors++;
+      }
+
+      wall = benchNow() - wall;
+      double us = (clock.now() - start) / 1e3 / sweeps;
+
+      printf("%s\n  {\"scl_hz\": %u, \"method\": \"%s\", \"op_ns\": %u, \"us_per_sweep\": %.1f, "
+             "\"us_per_sensor\": %.2f, \"clocks_per_sweep\": %.1f, \"host_us_per_sweep\": %.1f, "
+             "\"sweeps\": %u, \"errors\": %u}",
+             s || parallel ? "," : "", speeds[s], parallel ? "parallel" : "serial", opNs, us, us / 64,
+             (double) (wire.clocks - clocks) / sweeps, wall / 1e3 / sweeps, sweeps, errors);
+    }
+  }
+  printf("\n]\n");
+
+  return 0;
+}
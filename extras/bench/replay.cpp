@@ -0,0 +1,197 @@
+/*
+ * Bus trace record/replay for performance regression tests
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/replay.cpp DS7505.cpp \
+ *       extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp \
+ *       extras/host/DS7505Linux.cpp extras/host/DS7505Replay.cpp -o replay
+ *
+ * Record a trace of N sweeps over the eight DS7505 addresses of a bus (a
+ * /dev/i2c-N device, or "sim" for eight simulated sensors):
+ *
+ *   ./replay record /dev/i2c-1 trace.bin 100
+ *
+ * Replay it through the driver, print the cost as JSON and, given the
+ * JSON of a previous run, exit with 1 when a metric grew by more than the
+ * threshold (percent, 5 by default):
+ *
+ *   ./replay run trace.bin > base.json
+ *   ./replay run trace.bin base.json 5
+ */
+#include <DS7505Linux.h>
+#include <DS7505Replay.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static const int ROUNDS = 20;
+
+static uint64_t cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static double cpuNs()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int record(const char *bus, const char *path, int sweeps)
+{
+  DS7505SimBus sim;
+  DS7505Sim devices[8];
+  DS7505LinuxBus i2c;
+  DS7505Bus *target = &sim;
+  DS7505 sensors[8];
+
+  if (strcmp(bus, "sim") == 0) {
+    for (uint8_t i = 0; i < 8; i++)
+      sim.attach(0x48 | i, &devices[i]);
+  }
+  else if (i2c.open(bus)) {
+    target = &i2c;
+  }
+  else {
+    perror(bus);
+    return 2;
+  }
+
+  DS7505RecordBus rec(target);
+  if (!rec.open(path)) {
+    perror(path);
+    return 2;
+  }
+  DS7505Bus::select(&rec);
+
+  // absent addresses NACK, the replay leaves them out
+  for (uint8_t i = 0; i < 8; i++)
+    sensors[i].init(i >> 2 & 1, i >> 1 & 1, i & 1, DS7505::RES_12);
+
+  for (int s = 0; s < sweeps; s++) {
+    for (uint8_t i = 0; i < 8; i++) {
+      devices[i].setTemp(20.0 + i + 2.0 * sin(s / 10.0 + i));
+      sensors[i].getRaw();
+    }
+    if (target != &sim)
+      usleep(DS7505::conversionTimeMs(DS7505::RES_12) * 1000);
+  }
+
+  return 0;
+}
+
+//value of "key": in a flat JSON object, -1 when missing
+static double field(const char *json, const char *key)
+{
+  char pattern[64];
+  const char *p;
+
+  snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+  if (!(p = strstr(json, pattern)))
+    return -1;
+
+  return atof(p + strlen(pattern));
+}
+
+static int run(const char *path, const char *baseline, double threshold)
+{
+  DS7505ReplayBus bus;
+  DS7505 sensors[8];
+  double bestNs = 0;
+  uint64_t bestCycles = 0;
+  unsigned long reads = 0;
+
+  if (!bus.load(path)) {
+    fprintf(stderr, "%s: not a DS7505 trace\n", path);
+    return 2;
+  }
+  DS7505Bus::select(&bus);
+
+  for (int r = 0; r < ROUNDS; r++) {
+    bus.rewind();
+    reads = 0;
+
+    double ns = cpuNs();
+    uint64_t c = cycles();
+
+    for (size_t a = 0; a < bus.addresses().size(); a++) {
+      uint8_t i = bus.addresses()[a] & 0x7;
+      sensors[i].init(i >> 2 & 1, i >> 1 & 1, i & 1, DS7505::RES_12);
+    }
+
+    while (!bus.done()) {
+      for (size_t a = 0; a < bus.addresses().size(); a++) {
+        sensors[bus.addresses()[a] & 0x7].getRaw();
+        reads++;
+      }
+    }
+
+    c = cycles() - c;
+    ns = cpuNs() - ns;
+
+    if (r == 0 || ns < bestNs)
+      bestNs = ns;
+    if (r == 0 || c < bestCycles)
+      bestCycles = c;
+  }
+
+  char json[512];
+  snprintf(json, sizeof(json),
+           "{\"trace\": \"%s\", \"sensors\": %zu, \"reads\": %lu, \"transactions\": %lu, "
+           "\"bytes\": %lu, \"bus_time_us\": %.1f, \"cpu_ns\": %.0f, \"cycles\": %llu}",
+           path, bus.addresses().size(), reads, bus.transactions, bus.bytes,
+           bus.busTimeUs, bestNs, (unsigned long long) bestCycles);
+  printf("%s\n", json);
+
+  if (!baseline)
+    return 0;
+
+  FILE *f = fopen(baseline, "r");
+  char base[512] = "";
+  if (!f) {
+    perror(baseline);
+    return 2;
+  }
+  size_t len = fread(base, 1, sizeof(base) - 1, f);
+  base[len] = 0;
+  fclose(f);
+
+  static const char *metrics[] = { "transactions", "bytes", "bus_time_us", "cpu_ns", "cycles" };
+  int regressions = 0;
+
+  for (size_t m = 0; m < sizeof(metrics) / sizeof(metrics[0]); m++) {
+    double was = field(base, metrics[m]);
+    double now = field(json, metrics[m]);
+
+    if (was > 0 && now > was * (1 + threshold / 100)) {
+      fprintf(stderr, "regression: %s %.0f -> %.0f (+%.1f%%)\n",
+              metrics[m], was, now, (now / was - 1) * 100);
+      regressions++;
+    }
+  }
+
+  return regressions ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc == 5 && strcmp(argv[1], "record") == 0)
+    return record(argv[2], argv[3], atoi(argv[4]));
+
+  if (argc >= 3 && strcmp(argv[1], "run") == 0)
+    return run(argv[2], argc > 3 ? argv[3] : 0, argc > 4 ? atof(argv[4]) : 5);
+
+  fprintf(stderr, "usage: %s record <sim|/dev/i2c-N> <trace> <sweeps>\n"
+          "       %s run <trace> [baseline.json [threshold%%]]\n", argv[0], argv[0]);
+  return 2;
+}
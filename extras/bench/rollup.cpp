@@ -0,0 +1,107 @@
+/*
+ * Update cost and query speedup of the rollup pyramid
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/linux extras/bench/rollup.cpp \
+ *       extras/linux/DS7505Store.cpp -o rollup
+ *   ./rollup [dir] [days] [queries]
+ *
+ * A sensor converting every 25 ms is recorded for \ref days (7 by
+ * default) both in a store series and in the rollups kept by ds7505d,
+ * then windows ending now, as a dashboard asks for them, are answered by
+ * the rollups, by the store summaries and by scanning the store.
+ */
+#include "bench.h"
+#include <DS7505Rollup.h>
+#include <DS7505Store.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+static const uint64_t PERIOD = 25000; // us
+static const uint32_t EPOCH = 1699999200; // s, on the hour like dashboard windows
+
+typedef DS7505Rollup<60, 60, 168, int64_t, uint32_t> HostRollup;
+typedef DS7505Rollup<10, 15, 24> DeviceRollup;
+
+static int16_t sample(uint64_t n)
+{
+  return (int16_t) (((n / 4096 % 512) - 256 + (int16_t) (n * 2654435761u >> 29)) << 4);
+}
+
+template <typename R>
+static double updateNs(uint64_t samples)
+{
+  R *r = new R();
+  double ns = benchNsPerOp(samples, [&] {
+    for (uint64_t n = 0; n < samples; n++)
+      r->add(EPOCH + (uint32_t) (n * PERIOD / 1000000), sample(n));
+  }, 3);
+  benchKeep(*r);
+  delete r;
+  return ns;
+}
+
+int main(int argc, char **argv)
+{
+  std::string dir = argc > 1 ? argv[1] : "/tmp/ds7505-rollup";
+  double days = argc > 2 ? atof(argv[2]) : 7;
+  unsigned queries = argc > 3 ? atoi(argv[3]) : 200;
+  uint64_t samples = (uint64_t) (days * 86400e6 / PERIOD);
+  DS7505Store store;
+  DS7505Series series;
+  HostRollup *rollup = new HostRollup();
+
+  if (system(("rm -rf " + dir).c_str()) != 0 || !store.open(dir) || !store.open(series, 0, 0x48)) {
+    perror(dir.c_str());
+    return 1;
+  }
+
+  printf("[\n");
+  printf("  {\"name\": \"update_device\", \"ns_per_op\": %.2f, \"bytes\": %zu},\n",
+         updateNs<DeviceRollup>(samples), sizeof(DeviceRollup));
+  printf("  {\"name\": \"update_host\", \"ns_per_op\": %.2f, \"bytes\": %zu},\n",
+         updateNs<HostRollup>(samples), sizeof(HostRollup));
+
+  for (uint64_t n = 0; n < samples; n++) {
+    uint64_t t = EPOCH * 1000000ull + n * PERIOD;
+    series.append(t, sample(n));
+    rollup->add((uint32_t) (t / 1000000), sample(n));
+  }
+
+  uint32_t now = EPOCH + (uint32_t) (samples * PERIOD / 1000000) - 1;
+  static const uint32_t WINDOWS[] = { 60, 3600, 86400, 7 * 86400 };
+  static const char *LABELS[] = { "1m", "1h", "1d", "1w" };
+
+  for (unsigned w = 0; w < 4 && WINDOWS[w] <= days * 86400; w++) {
+    uint32_t t0 = now - WINDOWS[w] + 1;
+    HostRollup::Bucket b;
+    DS7505Summary s;
+
+    double ns = benchNsPerOp(queries, [&] {
+      for (unsigned q = 0; q < queries; q++) benchKeep(b = rollup->query(t0, now));
+    });
+    double summaryNs = benchNsPerOp(queries, [&] {
+      for (unsigned q = 0; q < queries; q++) benchKeep(s = series.summary(t0 * 1000000ull, now * 1000000ull + 999999));
+    });
+    double scanNs = benchNsPerOp(1, [&] {
+      DS7505Summary x;
+      series.scan(t0 * 1000000ull, now * 1000000ull + 999999, [&](uint64_t, int16_t raw) { x.add(raw); });
+      benchKeep(x);
+    }, 3);
+
+    if (b.count != s.count || b.sum != s.sum) {
+      fprintf(stderr, "%s: rollup %u samples, store %llu\n", LABELS[w], b.count, (unsigned long long) s.count);
+      return 1;
+    }
+
+    printf("  {\"name\": \"query_%s\", \"rollup_us\": %.2f, \"summary_us\": %.2f, \"scan_us\": %.2f, "
+           "\"speedup_summary\": %.1f, \"speedup_scan\": %.1f}%s\n",
+           LABELS[w], ns / 1e3, summaryNs / 1e3, scanNs / 1e3, summaryNs / ns, scanNs / ns,
+           w + 1 < 4 && WINDOWS[w + 1] <= days * 86400 ? "," : "");
+  }
+  printf("]\n");
+
+  delete rollup;
+  return 0;
+}
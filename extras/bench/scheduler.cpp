@@ -0,0 +1,124 @@
+/*
+ * Earliest deadline first sampling of mixed rate sensors in virtual time
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/scheduler.cpp DS7505.cpp DS7505Array.cpp \
+ *       DS7505Scheduler.cpp extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp -o scheduler
+ *   ./scheduler [minutes] [busy_ms]
+ *
+ * Eight simulated sensors on one 100 kHz bus: two sampled at 4 Hz (11
+ * bits), two at 1 Hz (12 bits) and four once a minute (9 bits). Each
+ * transaction moves the virtual clock by its bus time (9 bits a byte, 2
+ * for start and stop). The sensors were started 37 ms apart, their
+ * releases never line up on their own. Compared:
+ *
+ *   uniform    every sensor read every 250 ms, the fastest period
+ *   edf        DS7505Scheduler, the loop sleeping until next()
+ *   edf_window the same, sensors due within 50 ms merged into a sweep
+ *   edf_busy   the loop back only every 0 to busy_ms (300) ms
+ *
+ * For each: sweeps (wake-ups with bus traffic), reads and transactions
+ * per minute, bus utilisation, the lateness of the reads against their
+ * release (mean, max and earliest, negative when read early through the
+ * window), the deadline misses and the samples that did not match the
+ * register model.
+ */
+#include "bench.h"
+#include <DS7505Scheduler.h>
+#include <DS7505Sim.h>
+#include <stdlib.h>
+
+static const uint16_t periods[8] = { 250, 250, 1000, 1000, 60000, 60000, 60000, 60000 };
+static const DS7505::Resolution resolutions[8] = {
+  DS7505::RES_11, DS7505::RES_11, DS7505::RES_12, DS7505::RES_12,
+  DS7505::RES_09, DS7505::RES_09, DS7505::RES_09, DS7505::RES_09,
+};
+
+int main(int argc, char **argv)
+{
+  double minutes = argc > 1 ? atof(argv[1]) : 60;
+  unsigned busyMs = argc > 2 ? atoi(argv[2]) : 300;
+  static const char *names[] = { "uniform", "edf", "edf_window", "edf_busy" };
+
+  srand(1);
+  printf("[");
+  for (unsigned mode = 0; mode < 4; mode++) {
+    DS7505VirtualClock clock;
+    DS7505SimBus bus;
+    DS7505Sim sims[8];
+    DS7505Array array;
+    DS7505Scheduler scheduler(array);
+    uint64_t end = (uint64_t) (minutes * 60e9);
+    unsigned long sweeps = 0, reads = 0, errors = 0, misses = 0;
+    double late = 0, lateMax = 0, lateMin = 0;
+
+    bus.clock = &clock;
+    for (uint8_t i = 0; i < 8; i++)
+      bus.attach(0x48 | i, &sims[i]);
+    DS7505Bus::select(&bus);
+    array.init(0xFF, DS7505::RES_11);
+    for (uint8_t i = 0; i < 8; i++)
+      scheduler.add(i, periods[i], resolutions[i], clock.now() / 1000000 + i * 37);
+    scheduler.window = mode == 2 ? 50 : 0;
+
+    unsigned long transactions = bus.transactions, bytes = bus.bytes;
+    uint64_t start = clock.now();
+
+    while (clock.now() < end) {
+      uint32_t now = clock.now() / 1000000;
+      uint32_t release[8];
+      int16_t raw[8];
+
+      for (uint8_t i = 0; i < 8; i++) {
+        release[i] = scheduler.release(i);
+        sims[i].setTemp(20 + (rand() % 1600) / 100.0f);
+      }
+
+      unsigned long before = bus.transactions, beforeBytes = bus.bytes;
+      uint8_t read = mode == 0 ? array.sweep(raw) : scheduler.run(now, raw);
+      uint64_t busNs = ((bus.bytes - beforeBytes) * 9 + (bus.transactions - before) * 2) * 10000ull;
+
+      for (uint8_t i = 0; i < 8; i++) {
+        if (!(read & 1 << i))
+          continue;
+
+        double l = mode == 0 ? 0 : (int32_t) (now - release[i]);
+        late += l;
+        lateMax = l > lateMax ? l : lateMax;
+        lateMin = l < lateMin ? l : lateMin;
+        reads++;
+        if (raw[i] != sims[i].raw(DS7505::P_TEMP))
+          errors++;
+      }
+      sweeps += read != 0;
+      clock.sleep(busNs);
+
+      if (mode == 0) {
+        clock.advance(start + sweeps * 250000000ull);
+      }
+      else if (mode == 3) {
+        clock.sleep((1 + rand() % busyMs) * 1000000ull);
+      }
+      else {
+        uint32_t next = scheduler.next();
+        int32_t wait = (int32_t) (next - (uint32_t) (clock.now() / 1000000));
+        clock.sleep((wait > 0 ? wait : 1) * 1000000ull);
+      }
+    }
+
+    for (uint8_t i = 0; i < 8; i++)
+      misses += scheduler.misses(i);
+
+    double elapsed = (clock.now() - start) / 60e9;
+    double busNs = ((bus.bytes - bytes) * 9 + (bus.transactions - transactions) * 2) * 10000.0;
+
+    printf("%s\n  {\"mode\": \"%s\", \"minutes\": %.0f, \"sweeps_per_min\": %.1f, \"reads_per_min\": %.1f, "
+           "\"transactions_per_min\": %.1f, \"bus_utilisation\": %.5f, \"late_mean_ms\": %.2f, "
+           "\"late_max_ms\": %.0f, \"late_min_ms\": %.0f, \"misses\": %lu, \"errors\": %lu}",
+           mode ? "," : "", names[mode], elapsed, sweeps / elapsed, reads / elapsed,
+           (bus.transactions - transactions) / elapsed, busNs / (clock.now() - start),
+           reads ? late / reads : 0, lateMax, lateMin, misses, errors);
+  }
+  printf("\n]\n");
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Reader throughput of the shared memory table
+ *
+ *   g++ -std=c++11 -O2 -pthread -I. -Iextras/linux extras/bench/shm_readers.cpp \
+ *       extras/linux/DS7505Shm.cpp -o shm_readers
+ *   ./shm_readers [buses] [seconds] [max readers]
+ *
+ * A writer thread republishes every entry of a table in /dev/shm as fast
+ * as it can (far more often than real sensors convert) while 1, 2, 4, ...
+ * reader threads, each with its own read-only mapping as a separate
+ * process would have, snapshot every entry in turn.
+ */
+#include "bench.h"
+#include <DS7505Shm.h>
+#include <DS7505.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const char *NAME = "/ds7505-bench";
+
+static std::atomic<bool> stop;
+
+int main(int argc, char **argv)
+{
+  unsigned buses = argc > 1 ? atoi(argv[1]) : 16;
+  double seconds = argc > 2 ? atof(argv[2]) : 1;
+  unsigned maxReaders = argc > 3 ? atoi(argv[3]) : 2 * std::thread::hardware_concurrency();
+  DS7505ShmTable writer;
+  bool first = true;
+
+  if (!writer.create(NAME, buses)) {
+    perror(NAME);
+    return 1;
+  }
+
+  printf("[\n");
+
+  for (unsigned readers = 1; readers <= maxReaders; readers *= 2) {
+    std::vector<std::thread> threads;
+    std::vector<unsigned long> counts(readers * 16); // 16 apart, one cache line each
+    std::atomic<unsigned long> published(0);
+
+    stop = false;
+
+    threads.push_back(std::thread([&] {
+      DS7505Table &t = writer.table();
+      unsigned long n = 0;
+      for (int16_t v = 0; !stop; v++, n++)
+        t.publish(n % buses, 0x48 | (n / buses & 7), v, DS7505::ST_OK, n);
+      published = n;
+    }));
+
+    for (unsigned r = 0; r < readers; r++) {
+      threads.push_back(std::thread([&, r] {
+        DS7505ShmTable reader;
+        unsigned long n = 0;
+        int64_t sum = 0;
+
+        if (!reader.open(NAME))
+          return;
+
+        const DS7505Table &t = reader.table();
+        while (!stop) {
+          for (unsigned b = 0; b < buses; b++)
+            for (uint8_t a = 0; a < 8; a++)
+              sum += t.read(b, 0x48 | a).raw;
+          n += buses * 8;
+        }
+        benchKeep(sum);
+        counts[r * 16] = n;
+      }));
+    }
+
+    usleep((useconds_t) (seconds * 1e6));
+    stop = true;
+    for (size_t i = 0; i < threads.size(); i++)
+      threads[i].join();
+
+    unsigned long total = 0;
+    for (unsigned r = 0; r < readers; r++)
+      total += counts[r * 16];
+
+    printf("%s  {\"readers\": %u, \"entries\": %u, \"snapshots_per_s\": %.0f, "
+           "\"snapshots_per_s_per_reader\": %.0f, \"publishes_per_s\": %.0f}",
+           first ? "" : ",\n", readers, buses * 8, total / seconds,
+           total / seconds / readers, published / seconds);
+    first = false;
+  }
+
+  printf("\n]\n");
+  shm_unlink(NAME);
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * Bit-banged I2C through DS7505SoftI2C on the pin-level simulator
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/softi2c.cpp DS7505.cpp \
+ *       extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp extras/host/DS7505PinSim.cpp -o softi2c
+ *   ./softi2c [op_ns] [samples]
+ *
+ * The driver reads a DS7505 over a DS7505SoftBus in virtual time, at 100
+ * and 400 kHz and unthrottled, with and without a device stretching SCL
+ * for 10 us after each byte. Each pin access costs op_ns (125 ns, two
+ * AVR cycles at 16 MHz, by default). For each case: the time one sample
+ * (getRaw(), a 2 byte read) holds the bus and the CPU, the SCL frequency
+ * achieved over it, the same read on a hardware TWI at the nominal
+ * frequency (400 kHz when unthrottled) for reference, the host CPU per
+ * sample and the samples that did not match the register model.
+ */
+#include "bench.h"
+#include <DS7505PinSim.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+  unsigned opNs = argc > 1 ? atoi(argv[1]) : 125;
+  unsigned samples = argc > 2 ? atoi(argv[2]) : 2000;
+  static const uint32_t speeds[] = { 100000, 400000, 0 };
+  static const uint32_t stretches[] = { 0, 10000 };
+
+  printf("[");
+  for (unsigned s = 0; s < 3; s++) {
+    for (unsigned t = 0; t < 2; t++) {
+      DS7505VirtualClock clock;
+      DS7505SoftBus bus(speeds[s]);
+      DS7505Sim sim;
+      DS7505 sensor;
+      unsigned errors = 0;
+
+      bus.clock = &clock;
+      bus.wire.opNs = opNs;
+      bus.wire.stretchNs = stretches[t];
+      bus.wire.lanes[0].attach(0x48, &sim);
+      DS7505Bus::select(&bus);
+      sensor.init(0, 0, 0, DS7505::RES_12);
+      sensor.getRaw(); // points at P_TEMP from now on
+
+      uint64_t start = clock.now();
+      unsigned long clocks = bus.wire.clocks;
+      double wall = benchNow();
+
+      for (unsigned i = 0; i < samples; i++) {
+        sim.setTemp(20 + (i % 256) * 0.0625f);
+        if (sensor.getRaw() != sim.raw(DS7505::P_TEMP))
+          errors++;
+      }
+
+      wall = benchNow() - wall;
+      double us = (clock.now() - start) / 1e3 / samples;
+      double perSample = (double) (bus.wire.clocks - clocks) / samples;
+      uint32_t hz = speeds[s] ? speeds[s] : 400000;
+
+      printf("%s\n  {\"scl_hz\": %u, \"stretch_us\": %.0f, \"op_ns\": %u, \"us_per_sample\": %.1f, "
+             "\"clocks_per_sample\": %.1f, \"achieved_khz\": %.1f, \"twi_us_per_sample\": %.1f, "
+             "\"host_ns_per_sample\": %.0f, \"samples\": %u, \"errors\": %u}",
+             s || t ? "," : "", speeds[s], stretches[t] / 1e3, opNs, us, perSample,
+             perSample / us * 1e3, 29e6 / hz, wall / samples, samples, errors);
+    }
+  }
+  printf("\n]\n");
+
+  return 0;
+}
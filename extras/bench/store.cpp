@@ -0,0 +1,110 @@
+/*
+ * Ingest rate and range query latency of the time-series store
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/linux extras/bench/store.cpp \
+ *       extras/linux/DS7505Store.cpp -o store
+ *   ./store [dir] [samples] [queries]
+ *
+ * One sensor converting every 25 ms is appended \ref samples times
+ * (default 10^8, 10^9 needs ~6 GB of disk), then random windows of
+ * growing length are summarised and scanned. Summaries only read the
+ * columns at the two ends of a window, so their latency stays flat as the
+ * window grows while a scan is linear in it. The sizes of the three files
+ * on disk and the chunks they grew by (DS7505Series::CHUNK, one remap
+ * each) close the report.
+ */
+#include "bench.h"
+#include <DS7505Store.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+static const uint64_t PERIOD = 25000; // us
+
+static int16_t sample(uint64_t n)
+{
+  // slow sawtooth drift plus a little noise, 12-bit codes
+  return (int16_t) (((n / 4096 % 512) - 256 + (int16_t) (n * 2654435761u >> 29)) << 4);
+}
+
+int main(int argc, char **argv)
+{
+  std::string dir = argc > 1 ? argv[1] : "/tmp/ds7505-store";
+  uint64_t samples = argc > 2 ? strtoull(argv[2], 0, 0) : 100000000;
+  unsigned queries = argc > 3 ? atoi(argv[3]) : 1000;
+  DS7505Store store;
+  DS7505Series series;
+
+  if (!store.open(dir) || !store.open(series, 0, 0x48)) {
+    perror(dir.c_str());
+    return 1;
+  }
+
+  uint64_t have = series.size();
+  double t = benchNow();
+
+  for (uint64_t n = have; n < samples; n++)
+    if (!series.append(n * PERIOD, sample(n))) {
+      perror("append");
+      return 1;
+    }
+  series.sync();
+
+  double ingest = benchNow() - t;
+  uint64_t added = samples > have ? samples - have : 0;
+  uint64_t span = series.size() * PERIOD;
+
+  printf("[\n");
+  printf("  {\"name\": \"ingest\", \"samples\": %llu, \"ns_per_op\": %.2f, \"samples_per_s\": %.0f},\n",
+         (unsigned long long) added, added ? ingest / added : 0, added ? added / ingest * 1e9 : 0);
+
+  static const uint64_t WINDOWS[] = { 60, 3600, 86400, 7 * 86400 }; // s
+  static const char *LABELS[] = { "1m", "1h", "1d", "1w" };
+  srand(1);
+
+  for (unsigned w = 0; w < sizeof(WINDOWS) / sizeof(WINDOWS[0]); w++) {
+    uint64_t len = WINDOWS[w] * 1000000;
+    if (len > span)
+      break;
+
+    for (int scan = 0; scan < 2; scan++) {
+      std::vector<double> ns;
+      for (unsigned q = 0; q < queries; q++) {
+        uint64_t t0 = (uint64_t) ((double) rand() / RAND_MAX * (span - len));
+        double s = benchNow();
+        DS7505Summary sum;
+        if (scan)
+          series.scan(t0, t0 + len, [&](uint64_t, int16_t raw) { sum.add(raw); });
+        else
+          sum = series.summary(t0, t0 + len);
+        ns.push_back(benchNow() - s);
+        benchKeep(sum);
+      }
+      std::sort(ns.begin(), ns.end());
+      printf("  {\"name\": \"%s_%s\", \"p50_us\": %.2f, \"p99_us\": %.2f},\n",
+             scan ? "scan" : "summary", LABELS[w], ns[ns.size() / 2] / 1e3, ns[ns.size() * 99 / 100] / 1e3);
+    }
+  }
+
+  static const char *FILES[] = { "idx", "raw", "time" };
+  uint64_t bytes = 0, chunks = 0;
+
+  printf("  {\"name\": \"size\", \"samples\": %llu, \"blocks\": %llu",
+         (unsigned long long) series.size(), (unsigned long long) series.blockCount());
+  for (unsigned f = 0; f < 3; f++) {
+    struct stat st;
+    std::string path = dir + "/bus0-0x48." + FILES[f];
+
+    if (stat(path.c_str(), &st) < 0)
+      st.st_size = 0;
+    bytes += st.st_size;
+    chunks += st.st_size / DS7505Series::CHUNK;
+    printf(", \"%s_bytes\": %llu", FILES[f], (unsigned long long) st.st_size);
+  }
+  printf(", \"chunks\": %llu, \"bytes_per_sample\": %.2f}\n]\n",
+         (unsigned long long) chunks, series.size() ? (double) bytes / series.size() : 0);
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Host benchmark of the TOS/THYST encoder
+ *
+ * Compares DS7505::encodeTemp() with the cascaded compare/subtract encoder
+ * setThermostat() used to have, over -55..125 degree Celsius.
+ *
+ *   g++ -O2 -I. extras/bench/thermostat_encode.cpp -o thermostat_encode
+ *   ./thermostat_encode
+ */
+#include <DS7505.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// The encoder setThermostat() used before encodeTemp(), kept as is
+static void legacyEncode(float t, uint8_t &h, uint8_t &l)
+{
+  float r;
+
+  l = 0;
+
+  if (t >= 0) {
+    h = (uint8_t) t;
+  }
+  else {
+    h = 0x80 & (uint8_t) std::abs((int) t);
+  }
+
+  r = fabs((double) t) - (int) std::abs((int) t);
+
+  if (r >= 0.5 ) {
+    l |= 0x80;
+    r -= 0.5;
+  }
+
+  if (r >= 0.25) {
+    l |= 0x40;
+    r -= 0.25;
+  }
+
+  if (r >= 0.125) {
+    l |= 0x20;
+    r -= 0.125;
+  }
+
+  if (r >= 0.0625) {
+    l |= 0x10;
+  }
+}
+
+static const int SAMPLES = 180001; // -55..125 by 0.001 degree
+static const int ROUNDS = 200;
+
+static float inputs[SAMPLES];
+
+template <typename F>
+static double bench(F encode)
+{
+  volatile uint16_t sink = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for (int r = 0; r < ROUNDS; r++) {
+    uint16_t acc = 0;
+    for (int i = 0; i < SAMPLES; i++)
+      acc += encode(inputs[i]);
+    sink = sink + acc;
+  }
+
+  std::chrono::duration<double, std::nano> ns = std::chrono::steady_clock::now() - start;
+  return ns.count() / ((double) SAMPLES * ROUNDS);
+}
+
+int main()
+{
+  for (int i = 0; i < SAMPLES; i++)
+    inputs[i] = -55.0f + i * 0.001f;
+
+  // The programmed value must be the nearest step at every resolution
+  for (int res = DS7505::RES_09; res <= DS7505::RES_12; res++) {
+    float step = 1.0f / (2 << res);
+    for (int i = 0; i < SAMPLES; i++) {
+      float q = DS7505::decodeTemp(DS7505::encodeTemp(inputs[i], (DS7505::Resolution) res));
+      if (fabs(q - inputs[i]) > step / 2 + 1e-6f) {
+        printf("encodeTemp(%f, %d) = %f is not the nearest step\n", inputs[i], res, q);
+        return 1;
+      }
+    }
+  }
+
+  int differ = 0;
+  for (int i = 0; i < SAMPLES; i++) {
+    uint8_t h, l;
+    legacyEncode(inputs[i], h, l);
+    if ((uint16_t) DS7505::encodeTemp(inputs[i], DS7505::RES_12) != (h << 8 | l))
+      differ++;
+  }
+
+  double legacy = bench([](float t) { uint8_t h, l; legacyEncode(t, h, l); return (uint16_t) (h << 8 | l); });
+  double encode = bench([](float t) { return (uint16_t) DS7505::encodeTemp(t, DS7505::RES_12); });
+
+  printf("{\"samples\": %d, \"legacy_ns_per_op\": %.3f, \"encodeTemp_ns_per_op\": %.3f, "
+         "\"speedup\": %.2f, \"codes_differing_from_legacy\": %d}\n",
+         SAMPLES, legacy, encode, legacy / encode, differ);
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Throughput and latency of a shared bus under contending threads
+ *
+ *   g++ -std=c++11 -O2 -pthread -I. -Iextras/host extras/bench/threads.cpp \
+ *       DS7505.cpp extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp -o threads
+ *   ./threads [seconds] [max threads] [overhead us] [bit us]
+ *
+ * 1 to 64 threads read the temperature of eight simulated sensors on one
+ * shared bus. The bus charges what an i2c-dev adapter costs: a fixed
+ * overhead per transfer (syscall, setup, completion interrupt, 20 us by
+ * default) plus the bit time of every message (2.5 us at 400 kHz), spent
+ * asleep like a thread blocked in the ioctl while the controller works.
+ *
+ * "locked" runs each message in its own transfer, as a mutex around the
+ * driver would; "batched" sends everything a combiner collected in one.
+ */
+#include "bench.h"
+#include <DS7505Sim.h>
+#include <algorithm>
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/prctl.h>
+#include <thread>
+#include <vector>
+
+class TimedBus : public DS7505SimBus
+{
+
+public:
+
+  TimedBus(double overheadNs, double bitNs) : batching(false), _overhead(overheadNs), _bit(bitNs) {};
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n)
+  {
+    if (!_inBatch) sleep(_overhead + message(n));
+    return DS7505SimBus::write(addr, data, n);
+  }
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n)
+  {
+    if (!_inBatch) sleep(_overhead + message(n));
+    return DS7505SimBus::read(addr, data, n);
+  }
+
+  virtual uint8_t transfer(Message *msgs, size_t count)
+  {
+    if (!batching)
+      return DS7505Bus::transfer(msgs, count);
+
+    double ns = _overhead;
+    for (size_t i = 0; i < count; i++)
+      ns += message(msgs[i].n);
+    sleep(ns);
+
+    _inBatch = true;
+    uint8_t status = DS7505Bus::transfer(msgs, count);
+    _inBatch = false;
+
+    return status;
+  }
+
+  bool batching;
+
+private:
+  double _overhead;
+  double _bit;
+  bool _inBatch = false;
+
+  // (repeated) start, address and data bytes with their ack bits
+  double message(uint8_t n) const { return (1 + 9 * (n + 1)) * _bit; }
+
+  static void sleep(double ns)
+  {
+    struct timespec ts;
+    uint64_t t = (uint64_t) (benchNow() + ns);
+
+    ts.tv_sec = t / 1000000000;
+    ts.tv_nsec = t % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR)
+      ;
+  }
+};
+
+int main(int argc, char **argv)
+{
+  double seconds = argc > 1 ? atof(argv[1]) : 0.5;
+  unsigned maxThreads = argc > 2 ? atoi(argv[2]) : 64;
+  double overhead = (argc > 3 ? atof(argv[3]) : 20) * 1e3;
+  double bit = (argc > 4 ? atof(argv[4]) : 2.5) * 1e3;
+  DS7505Sim sims[8];
+  TimedBus bus(overhead, bit);
+  bool first = true;
+
+  for (uint8_t i = 0; i < 8; i++) {
+    sims[i].setTemp(20 + i * 1.5);
+    bus.attach(0x48 | i, &sims[i]);
+  }
+  bus.setShared(true);
+
+  // the default 50us timer slack would dwarf the bit times
+  prctl(PR_SET_TIMERSLACK, 1000ul);
+
+  printf("[\n");
+
+  for (int batching = 0; batching < 2; batching++) {
+    bus.batching = batching;
+
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+      std::vector<std::thread> pool;
+      std::vector<std::vector<float> > latency(threads);
+      std::vector<unsigned long> errors(threads);
+      double end = benchNow() + seconds * 1e9;
+      unsigned long batches = bus.batches, batched = bus.batched;
+
+      for (unsigned t = 0; t < threads; t++) {
+        pool.push_back(std::thread([&, t] {
+          uint8_t i = t & 7;
+          DS7505 sensor;
+
+          DS7505Bus::select(&bus);
+          sensor.init(i >> 2 & 1, i >> 1 & 1, i & 1, DS7505::RES_12);
+          int16_t expected = sims[i].raw(DS7505::P_TEMP);
+
+          latency[t].reserve(1 << 16);
+          for (double now = benchNow(); now < end; ) {
+            int16_t raw = sensor.getRaw();
+            double done = benchNow();
+            latency[t].push_back((float) (done - now));
+            errors[t] += raw != expected;
+            now = done;
+          }
+        }));
+      }
+      for (unsigned t = 0; t < threads; t++)
+        pool[t].join();
+
+      std::vector<float> all;
+      unsigned long errs = 0;
+      for (unsigned t = 0; t < threads; t++) {
+        all.insert(all.end(), latency[t].begin(), latency[t].end());
+        errs += errors[t];
+      }
+      std::sort(all.begin(), all.end());
+
+      printf("%s  {\"name\": \"%s_%u\", \"threads\": %u, \"ops_per_s\": %.0f, \"p50_us\": %.1f, "
+             "\"p99_us\": %.1f, \"ops_per_batch\": %.2f, \"errors\": %lu}",
+             first ? "" : ",\n", batching ? "batched" : "locked", threads, threads, all.size() / seconds,
+             all[all.size() / 2] / 1e3, all[all.size() * 99 / 100] / 1e3,
+             bus.batches > batches ? (double) (bus.batched - batched) / (bus.batches - batches) : 0, errs);
+      first = false;
+    }
+  }
+
+  printf("\n]\n");
+
+  return 0;
+}
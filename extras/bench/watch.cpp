@@ -0,0 +1,128 @@
+/*
+ * Change reporting by polling every conversion versus DS7505Watch
+ *
+ *   g++ -std=c++11 -O2 -I. -Iextras/host extras/bench/watch.cpp DS7505.cpp \
+ *       DS7505Watch.cpp extras/host/DS7505Bus.cpp extras/host/DS7505Sim.cpp -o watch
+ *   ./watch [hours] [delta] [heartbeat_s] [bits]
+ *
+ * One room in virtual time: a slow daily drift, a heater on for half an
+ * hour twice a day, a window opened once, and measurement noise. Both
+ * runs see the same conversions and report whenever the temperature moved
+ * by delta (0.25 C by default) since the last report:
+ *
+ *   poll   reads every conversion
+ *   watch  sleeps until O.S. fires or the heartbeat (60 s by default) is due
+ *
+ * For each, the bus traffic, the wake-ups and the reports, then how far
+ * the last report was from the temperature register: the worst error and
+ * the time spent delta or more off, which the heartbeat bounds.
+ */
+#include "bench.h"
+#include <DS7505Sim.h>
+#include <DS7505Watch.h>
+#include <stdlib.h>
+
+struct Run
+{
+  DS7505Plant plant;
+  DS7505Sim sim;
+  DS7505SimBus bus;
+  DS7505VirtualClock clock;
+  DS7505 sensor;
+  unsigned long wakeups;
+  unsigned long reports;
+  int16_t reported;
+  int16_t maxError;
+  uint64_t staleNs;
+
+  Run() : plant(21.0f, 900.0f, 7), wakeups(0), reports(0), reported(0), maxError(0), staleNs(0)
+  {
+    plant.drift = 1.5f;
+    plant.noise = 0.02f;
+    for (float day = 0; day < 30 * 86400.0f; day += 86400)
+      for (float h = 7; h < 24; h += 11)
+        plant.addSource(day + h * 3600, day + h * 3600 + 1800, 3.0f);
+    plant.addStep(15 * 3600, -2.0f);
+    sim.setPlant(&plant);
+    bus.attach(0x48, &sim);
+    bus.clock = &clock;
+  }
+
+  //error of the last report against the register, at each conversion
+  void check(int16_t delta, uint64_t period)
+  {
+    int16_t error = abs(sim.raw(DS7505::P_TEMP) - reported);
+
+    if (error > maxError)
+      maxError = error;
+    if (error >= delta)
+      staleNs += period;
+  }
+
+  void print(const char *mode, double hours)
+  {
+    printf("{\"mode\": \"%s\", \"hours\": %.1f, \"transactions\": %lu, \"bytes\": %lu, "
+           "\"wakeups\": %lu, \"reports\": %lu, \"max_error_c\": %.4f, \"stale_s\": %.1f}\n",
+           mode, hours, bus.transactions, bus.bytes, wakeups, reports,
+           DS7505::decodeTemp(maxError), staleNs / 1e9);
+  }
+};
+
+int main(int argc, char **argv)
+{
+  double hours = argc > 1 ? atof(argv[1]) : 24;
+  float deltaC = argc > 2 ? atof(argv[2]) : 0.25f;
+  unsigned heartbeat = argc > 3 ? atoi(argv[3]) : 60;
+  unsigned bits = argc > 4 ? atoi(argv[4]) : 12;
+  DS7505::Resolution res = (DS7505::Resolution) (bits - 9);
+  int16_t delta = DS7505::encodeTemp(deltaC, res);
+  uint64_t period = DS7505::conversionTimeMs(res) * 1000000ull;
+  uint64_t end = (uint64_t) (hours * 3600e9);
+  Run *poll = new Run(), *watched = new Run();
+
+  DS7505Bus::select(&poll->bus);
+  poll->sensor.init(0, 0, 0, res);
+  poll->reported = poll->sensor.getRaw();
+
+  for (uint64_t t = period; t <= end; t += period) {
+    poll->clock.advance(t);
+    poll->wakeups++;
+
+    int16_t raw = poll->sensor.getRaw();
+    if (abs(raw - poll->reported) >= delta) {
+      poll->reported = raw;
+      poll->reports++;
+    }
+    poll->check(delta, period);
+  }
+  poll->print("poll", hours);
+
+  DS7505Watch watch(watched->sensor);
+  uint64_t beat = 0;
+
+  DS7505Bus::select(&watched->bus);
+  watched->sensor.init(0, 0, 0, res);
+  watch.begin(delta, DS7505::FT_2);
+  watched->reported = watch.raw();
+
+  for (uint64_t t = period; t <= end; t += period) {
+    watched->clock.advance(t);
+    watched->sim.tick(t / 1000); // the pin, no bus access
+
+    if (watched->sim.os() || t - beat >= heartbeat * 1000000000ull) {
+      beat = t;
+      watched->wakeups++;
+      if (watch.update()) {
+        watched->reported = watch.raw();
+        watched->reports++;
+      }
+    }
+    watched->check(delta, period);
+  }
+  watched->print("watch", hours);
+
+  delete poll;
+  delete watched;
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+#include "DS7505Async.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+size_t DS7505Frame::allocated = 0;
+
+void *DS7505Frame::operator new(size_t size)
+{
+  allocated += size;
+  return ::operator new(size);
+}
+
+void DS7505Frame::operator delete(void *p, size_t size)
+{
+  allocated -= size;
+  ::operator delete(p);
+}
+
+//top level coroutine of a spawned task, frees itself when over
+struct DS7505Loop::Spawned
+{
+  struct promise_type : DS7505Frame {
+    Spawned get_return_object() { return Spawned { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  std::coroutine_handle<promise_type> h;
+};
+
+DS7505Loop::DS7505Loop(DS7505Clock &clock) : _clock(clock), _tasks(0), _inflight(0)
+{
+  if ((_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    abort();
+}
+
+DS7505Loop::~DS7505Loop()
+{
+  close(_event);
+}
+
+DS7505Loop::Spawned DS7505Loop::drive(DS7505Loop *loop, DS7505Task<void> task)
+{
+  co_await task;
+  loop->_tasks--;
+}
+
+void DS7505Loop::spawn(DS7505Task<void> task)
+{
+  _tasks++;
+  _ready.push_back(drive(this, static_cast<DS7505Task<void> &&>(task)).h);
+}
+
+void DS7505Loop::complete(std::coroutine_handle<> h)
+{
+  std::lock_guard<std::mutex> lock(_lock);
+  uint64_t one = 1;
+
+  if (_completed.empty() && write(_event, &one, sizeof(one)) < 0)
+    abort();
+  _completed.push_back(h);
+  _inflight--;
+}
+
+//resume whatever is ready, then sleep until the next timer or completion
+void DS7505Loop::run()
+{
+  std::vector<std::coroutine_handle<> > ready;
+
+  while (_tasks) {
+    ready.swap(_ready);
+    for (size_t i = 0; i < ready.size(); i++)
+      ready[i].resume();
+    ready.clear();
+
+    uint64_t t = now();
+    while (!_timers.empty() && _timers.top().t <= t) {
+      _ready.push_back(_timers.top().h);
+      _timers.pop();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_lock);
+      _ready.insert(_ready.end(), _completed.begin(), _completed.end());
+      _completed.clear();
+    }
+
+    if (!_ready.empty() || !_tasks)
+      continue;
+
+    struct pollfd pfd = { _event, POLLIN, 0 };
+    struct timespec timeout;
+    uint64_t wait = _timers.empty() ? 1000000000ull : _timers.top().t - t;
+
+    // virtual time jumps to the next timer once the bus threads are done
+    if (!_clock.realTime() && _inflight == 0) {
+      _clock.sleep(wait);
+      continue;
+    }
+
+    timeout.tv_sec = wait / 1000000000ull;
+    timeout.tv_nsec = wait % 1000000000ull;
+    if (ppoll(&pfd, 1, _clock.realTime() ? &timeout : 0, 0) > 0) {
+      uint64_t n;
+      if (read(_event, &n, sizeof(n)) < 0 && errno != EAGAIN)
+        abort();
+    }
+  }
+}
+
+DS7505AsyncBus::DS7505AsyncBus(DS7505Loop &loop, DS7505Bus &bus, bool threaded)
+  : _loop(loop), _bus(bus), _head(0), _tail(0), _threaded(threaded), _stop(false)
+{
+  if (threaded)
+    _thread = std::thread(&DS7505AsyncBus::work, this);
+}
+
+DS7505AsyncBus::~DS7505AsyncBus()
+{
+  if (!_threaded)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+    _stop = true;
+  }
+  _wake.notify_one();
+  _thread.join();
+}
+
+bool DS7505AsyncBus::submit(DS7505AsyncOp *op)
+{
+  if (!_threaded) {
+    DS7505Bus *previous = DS7505Bus::current();
+    DS7505Bus::select(&_bus);
+    op->invoke(op);
+    DS7505Bus::select(previous);
+    return false;
+  }
+
+  _loop.expect();
+
+  std::lock_guard<std::mutex> lock(_lock);
+  op->next = 0;
+  if (_tail)
+    _tail->next = op;
+  else
+    _head = op;
+  _tail = op;
+  _wake.notify_one();
+
+  return true;
+}
+
+//bus thread: run the queued ops in order, blocking in the transfers
+void DS7505AsyncBus::work()
+{
+  DS7505Bus::select(&_bus);
+
+  for (;;) {
+    DS7505AsyncOp *op;
+
+    {
+      std::unique_lock<std::mutex> lock(_lock);
+      _wake.wait(lock, [this] { return _head || _stop; });
+      if (!_head)
+        return;
+      op = _head;
+      _head = _tail = 0;
+    }
+
+    while (op) {
+      DS7505AsyncOp *next = op->next; // op is gone once its task resumes
+      op->invoke(op);
+      _loop.complete(op->waiter);
+      op = next;
+    }
+  }
+}
@@ -0,0 +1,374 @@
+#ifndef DS7505_ASYNC_H
+#define DS7505_ASYNC_H
+
+#include "DS7505Bus.h"
+#include <DS7505Array.h>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//! Coroutine API of the driver on hosts (needs C++20)
+/*!
+ * Sensor tasks are coroutines multiplexed on the thread running a
+ * DS7505Loop. They suspend while waiting for a conversion and, on buses
+ * that block (i2c-dev), while their transfers run on the bus thread.
+ *
+ * \code
+ *
+ *  DS7505Task<void> poll(DS7505Loop &loop, DS7505AsyncSensor &sensor)
+ *  {
+ *    co_await sensor.init(0, 0, 0, DS7505::RES_12);
+ *    co_await sensor.setThermostat(32.45f, 30.14f, DS7505::FT_6);
+ *    for (;;) {
+ *      co_await loop.sleep(sensor.conversionTimeMs() * 1000000ull);
+ *      printf("%f\n", DS7505::decodeTemp(co_await sensor.readRaw()));
+ *    }
+ *  }
+ *
+ *  DS7505Loop loop;
+ *  DS7505LinuxBus i2c;
+ *  i2c.open("/dev/i2c-1");
+ *  DS7505AsyncBus bus(loop, i2c, true);
+ *  DS7505AsyncSensor sensor(bus);
+ *  loop.spawn(poll(loop, sensor));
+ *  loop.run();
+ *
+ * \endcode
+ *
+ * Built with -std=c++20 -I. -Iextras/host, see extras/bench/async.cpp.
+ */
+class DS7505Loop;
+
+//! Coroutine frame allocation, counted to measure the memory per task
+struct DS7505Frame
+{
+  static void *operator new(size_t size);
+  static void operator delete(void *p, size_t size);
+
+  //! Bytes of coroutine frames currently allocated
+  static size_t allocated;
+};
+
+template <typename T>
+class DS7505Task;
+
+template <typename T>
+struct DS7505Promise : DS7505Frame
+{
+  std::coroutine_handle<> continuation;
+  T value;
+
+  DS7505Task<T> get_return_object();
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  void return_value(T v) { value = v; }
+  void unhandled_exception() { std::terminate(); }
+
+  struct Final {
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<DS7505Promise> h) noexcept
+    {
+      return h.promise().continuation;
+    }
+    void await_resume() noexcept {}
+  };
+
+  Final final_suspend() noexcept { return {}; }
+};
+
+template <>
+struct DS7505Promise<void> : DS7505Frame
+{
+  std::coroutine_handle<> continuation;
+
+  DS7505Task<void> get_return_object();
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  void return_void() {}
+  void unhandled_exception() { std::terminate(); }
+
+  struct Final {
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<DS7505Promise> h) noexcept
+    {
+      return h.promise().continuation;
+    }
+    void await_resume() noexcept {}
+  };
+
+  Final final_suspend() noexcept { return {}; }
+};
+
+//! A coroutine returning T, started when awaited or spawned
+template <typename T>
+class DS7505Task
+{
+
+public:
+
+  typedef DS7505Promise<T> promise_type;
+
+  explicit DS7505Task(std::coroutine_handle<promise_type> h) : _h(h) {};
+
+  DS7505Task(DS7505Task &&t) : _h(t._h) { t._h = nullptr; }
+
+  ~DS7505Task() { if (_h) _h.destroy(); }
+
+  bool await_ready() const { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller)
+  {
+    _h.promise().continuation = caller;
+    return _h;
+  }
+
+  T await_resume()
+  {
+    if constexpr (!std::is_void_v<T>)
+      return _h.promise().value;
+  }
+
+  //! Takes the coroutine, see DS7505Loop::spawn()
+  std::coroutine_handle<promise_type> release() { std::coroutine_handle<promise_type> h = _h; _h = nullptr; return h; }
+
+private:
+  std::coroutine_handle<promise_type> _h;
+};
+
+template <typename T>
+DS7505Task<T> DS7505Promise<T>::get_return_object()
+{
+  return DS7505Task<T>(std::coroutine_handle<DS7505Promise>::from_promise(*this));
+}
+
+inline DS7505Task<void> DS7505Promise<void>::get_return_object()
+{
+  return DS7505Task<void>(std::coroutine_handle<DS7505Promise>::from_promise(*this));
+}
+
+//! Single threaded scheduler of the sensor tasks
+class DS7505Loop
+{
+
+public:
+
+  //! Builds a loop
+  /*!
+   * \param clock Its time source: on a virtual clock the loop jumps from
+   * timer to timer instead of sleeping
+   */
+  explicit DS7505Loop(DS7505Clock &clock = DS7505Clock::real());
+
+  ~DS7505Loop();
+
+  //! Runs a task to completion, the loop owns it
+  void spawn(DS7505Task<void> task);
+
+  //! Runs until every spawned task is over
+  void run();
+
+  //! The time of the clock in nanoseconds
+  uint64_t now() { return _clock.now(); }
+
+  struct Sleep {
+    DS7505Loop &loop;
+    uint64_t until;
+
+    bool await_ready() const { return until <= loop.now(); }
+    void await_suspend(std::coroutine_handle<> h) { loop._timers.push(Timer { until, h }); }
+    void await_resume() const {}
+  };
+
+  //! Suspends the calling task for \ref ns nanoseconds
+  Sleep sleep(uint64_t ns) { return Sleep { *this, now() + ns }; }
+
+  //! Suspends the calling task until the monotonic time \ref t
+  Sleep until(uint64_t t) { return Sleep { *this, t }; }
+
+  //! Announces a complete() to come from another thread
+  void expect() { _inflight++; }
+
+  //! Resumes \ref h from the loop, callable from any thread
+  void complete(std::coroutine_handle<> h);
+
+  //! Tasks spawned and not over yet
+  size_t tasks() const { return _tasks; }
+
+private:
+  struct Timer {
+    uint64_t t;
+    std::coroutine_handle<> h;
+
+    bool operator>(const Timer &o) const { return t > o.t; }
+  };
+
+  struct Spawned;
+
+  DS7505Clock &_clock;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > _timers;
+  std::vector<std::coroutine_handle<> > _ready;
+  std::mutex _lock; // guards _completed
+  std::vector<std::coroutine_handle<> > _completed;
+  int _event; // eventfd, written when _completed fills
+  size_t _tasks;
+  std::atomic<size_t> _inflight; // expected completions
+
+  static Spawned drive(DS7505Loop *loop, DS7505Task<void> task);
+};
+
+//! A driver call queued on a DS7505AsyncBus
+struct DS7505AsyncOp
+{
+  void (*invoke)(DS7505AsyncOp *op);
+  std::coroutine_handle<> waiter;
+  DS7505AsyncOp *next;
+};
+
+//! A DS7505Bus driven from the coroutines of a DS7505Loop
+/*!
+ * Calls of the synchronous driver (DS7505, DS7505Array) are run in turn
+ * with the bus selected, so pointer caching, retries and statistics work
+ * as usual. On a threaded bus they run on a thread of their own while the
+ * task waits suspended, which suits the blocking i2c-dev ioctl; otherwise
+ * (simulator) they run inline without suspending.
+ */
+class DS7505AsyncBus
+{
+
+public:
+
+  //! Wraps a bus
+  /*!
+   * \param loop The loop resuming the tasks
+   * \param bus The bus
+   * \param threaded Whether to run the transfers on a bus thread
+   */
+  DS7505AsyncBus(DS7505Loop &loop, DS7505Bus &bus, bool threaded = false);
+
+  ~DS7505AsyncBus();
+
+  template <typename F>
+  class Call : public DS7505AsyncOp
+  {
+
+  public:
+
+    typedef std::invoke_result_t<F &> Result;
+
+    Call(DS7505AsyncBus &bus, F f) : _bus(bus), _f(f) { invoke = run; }
+
+    bool await_ready() const { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) { waiter = h; return _bus.submit(this); }
+
+    Result await_resume()
+    {
+      if constexpr (!std::is_void_v<Result>)
+        return _result;
+    }
+
+  private:
+    struct None {};
+
+    DS7505AsyncBus &_bus;
+    F _f;
+    std::conditional_t<std::is_void_v<Result>, None, Result> _result;
+
+    static void run(DS7505AsyncOp *op)
+    {
+      Call *c = static_cast<Call *>(op);
+
+      if constexpr (std::is_void_v<Result>)
+        c->_f();
+      else
+        c->_result = c->_f();
+    }
+  };
+
+  //! Awaitable running f() on the bus, resumes with its result
+  template <typename F>
+  Call<F> call(F f) { return Call<F>(*this, f); }
+
+  //! Awaitable DS7505Array::sweep(), resumes with the sensors read
+  auto sweep(DS7505Array &array, int16_t raw[8]) { return call([&array, raw] { return array.sweep(raw); }); }
+
+  //! The wrapped bus
+  DS7505Bus &bus() { return _bus; }
+
+  //! The loop resuming the tasks
+  DS7505Loop &loop() { return _loop; }
+
+private:
+  DS7505Loop &_loop;
+  DS7505Bus &_bus;
+  std::thread _thread;
+  std::mutex _lock; // guards _head, _tail and _stop
+  std::condition_variable _wake;
+  DS7505AsyncOp *_head;
+  DS7505AsyncOp *_tail;
+  bool _threaded;
+  bool _stop;
+
+  //! Queues an op, false when it already ran
+  bool submit(DS7505AsyncOp *op);
+
+  void work();
+};
+
+//! A DS7505 used from coroutines
+/*!
+ * The awaitables live in the frame of the awaiting task: a pending
+ * operation allocates nothing.
+ */
+class DS7505AsyncSensor
+{
+
+public:
+
+  explicit DS7505AsyncSensor(DS7505AsyncBus &bus) : _bus(bus), _res(DS7505::RES_12) {};
+
+  //! Awaitable DS7505::init()
+  auto init(uint8_t a2, uint8_t a1, uint8_t a0, DS7505::Resolution res)
+  {
+    _res = res;
+    return _bus.call([this, a2, a1, a0, res] { _sensor.init(a2, a1, a0, res); });
+  }
+
+  //! Awaitable DS7505::getRaw(), resumes with the raw code
+  auto readRaw(DS7505::Register reg = DS7505::P_TEMP)
+  {
+    return _bus.call([this, reg] { return _sensor.getRaw(reg); });
+  }
+
+  //! Awaitable DS7505::setThermostatC(), resumes with the DS7505::Thermostat programmed
+  auto setThermostat(float tos, float thyst, DS7505::FaultTolerance ft = DS7505::FT_1)
+  {
+    return _bus.call([this, tos, thyst, ft] { return _sensor.setThermostatC(tos, thyst, ft); });
+  }
+
+  //! Awaitable DS7505::setConfig()
+  auto setConfig(DS7505::Config config)
+  {
+    return _bus.call([this, config] { _sensor.setConfig(config); });
+  }
+
+  //! Suspends for a conversion period at the configured resolution
+  DS7505Loop::Sleep conversion() { return _bus.loop().sleep(conversionTimeMs() * 1000000ull); }
+
+  //! Reads the temperature in Celsius
+  DS7505Task<float> readTempC() { co_return DS7505::decodeTemp(co_await readRaw()); }
+
+  //! Maximum conversion time in milliseconds at the resolution set by init()
+  uint8_t conversionTimeMs() const { return DS7505::conversionTimeMs(_res); }
+
+private:
+  DS7505AsyncBus &_bus;
+  DS7505 _sensor;
+  DS7505::Resolution _res;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "DS7505Batch.h"
+
+// the kernels must round exactly as the scalar code, no fused multiply-add
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DS7505_BATCH_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define DS7505_BATCH_NEON
+#include <arm_neon.h>
+#endif
+
+//reference codes, also used for the tails of the SIMD kernels
+static void convertScalar(const int16_t *raw, float *out, size_t n, DS7505Batch::Unit unit)
+{
+  if (unit == DS7505Batch::UNIT_C) {
+    for (size_t i = 0; i < n; i++)
+      out[i] = DS7505::decodeTemp(raw[i]);
+  }
+  else {
+    for (size_t i = 0; i < n; i++)
+      out[i] = DS7505::toFahrenheit(DS7505::decodeTemp(raw[i]));
+  }
+}
+
+// Celsius is raw / 256 exactly. toFahrenheit() computes 9.0/5.0 * c + 32.0
+// in double before rounding to float, the kernels do the same in double
+// lanes so every result rounds identically.
+
+#if defined(DS7505_BATCH_X86)
+__attribute__((target("sse2")))
+static void convertSSE2(const int16_t *raw, float *out, size_t n, DS7505Batch::Unit unit)
+{
+  const __m128 scale = _mm_set1_ps(1.0f / 256);
+  const __m128d ratio = _mm_set1_pd(9.0 / 5.0);
+  const __m128d offset = _mm_set1_pd(32.0);
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    __m128i codes = _mm_loadu_si128((const __m128i *) (raw + i));
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(codes, codes), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(codes, codes), 16);
+    __m128 clo = _mm_mul_ps(_mm_cvtepi32_ps(lo), scale);
+    __m128 chi = _mm_mul_ps(_mm_cvtepi32_ps(hi), scale);
+
+    if (unit == DS7505Batch::UNIT_F) {
+      __m128d d0 = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(clo), ratio), offset);
+      __m128d d1 = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(clo, clo)), ratio), offset);
+      __m128d d2 = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(chi), ratio), offset);
+      __m128d d3 = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(chi, chi)), ratio), offset);
+      clo = _mm_movelh_ps(_mm_cvtpd_ps(d0), _mm_cvtpd_ps(d1));
+      chi = _mm_movelh_ps(_mm_cvtpd_ps(d2), _mm_cvtpd_ps(d3));
+    }
+
+    _mm_storeu_ps(out + i, clo);
+    _mm_storeu_ps(out + i + 4, chi);
+  }
+
+  convertScalar(raw + i, out + i, n - i, unit);
+}
+
+__attribute__((target("avx2")))
+static void convertAVX2(const int16_t *raw, float *out, size_t n, DS7505Batch::Unit unit)
+{
+  const __m256 scale = _mm256_set1_ps(1.0f / 256);
+  const __m256d ratio = _mm256_set1_pd(9.0 / 5.0);
+  const __m256d offset = _mm256_set1_pd(32.0);
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m256i codes = _mm256_loadu_si256((const __m256i *) (raw + i));
+    __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(codes));
+    __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(codes, 1));
+    __m256 clo = _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale);
+    __m256 chi = _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale);
+
+    if (unit == DS7505Batch::UNIT_F) {
+      __m256d d0 = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(clo)), ratio), offset);
+      __m256d d1 = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(clo, 1)), ratio), offset);
+      __m256d d2 = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(chi)), ratio), offset);
+      __m256d d3 = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(chi, 1)), ratio), offset);
+      clo = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(d0)), _mm256_cvtpd_ps(d1), 1);
+      chi = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(d2)), _mm256_cvtpd_ps(d3), 1);
+    }
+
+    _mm256_storeu_ps(out + i, clo);
+    _mm256_storeu_ps(out + i + 8, chi);
+  }
+
+  convertScalar(raw + i, out + i, n - i, unit);
+}
+#endif
+
+#if defined(DS7505_BATCH_NEON)
+static void convertNEON(const int16_t *raw, float *out, size_t n, DS7505Batch::Unit unit)
+{
+  const float64x2_t ratio = vdupq_n_f64(9.0 / 5.0);
+  const float64x2_t offset = vdupq_n_f64(32.0);
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t codes = vld1q_s16(raw + i);
+    float32x4_t clo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(codes))), 1.0f / 256);
+    float32x4_t chi = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(codes))), 1.0f / 256);
+
+    if (unit == DS7505Batch::UNIT_F) {
+      float64x2_t d0 = vaddq_f64(vmulq_f64(vcvt_f64_f32(vget_low_f32(clo)), ratio), offset);
+      float64x2_t d1 = vaddq_f64(vmulq_f64(vcvt_high_f64_f32(clo), ratio), offset);
+      float64x2_t d2 = vaddq_f64(vmulq_f64(vcvt_f64_f32(vget_low_f32(chi)), ratio), offset);
+      float64x2_t d3 = vaddq_f64(vmulq_f64(vcvt_high_f64_f32(chi), ratio), offset);
+      clo = vcvt_high_f32_f64(vcvt_f32_f64(d0), d1);
+      chi = vcvt_high_f32_f64(vcvt_f32_f64(d2), d3);
+    }
+
+    vst1q_f32(out + i, clo);
+    vst1q_f32(out + i + 4, chi);
+  }
+
+  convertScalar(raw + i, out + i, n - i, unit);
+}
+#endif
+
+void DS7505Batch::convertRaw(const int16_t *raw, float *out, size_t n, Unit unit, Kernel kernel)
+{
+  switch (kernel) {
+#if defined(DS7505_BATCH_X86)
+  case K_SSE2:
+    convertSSE2(raw, out, n, unit);
+    return;
+  case K_AVX2:
+    convertAVX2(raw, out, n, unit);
+    return;
+#endif
+#if defined(DS7505_BATCH_NEON)
+  case K_NEON:
+    convertNEON(raw, out, n, unit);
+    return;
+#endif
+  default:
+    convertScalar(raw, out, n, unit);
+  }
+}
+
+bool DS7505Batch::supported(Kernel kernel)
+{
+  switch (kernel) {
+  case K_SCALAR:
+    return true;
+#if defined(DS7505_BATCH_X86)
+  case K_SSE2:
+    return __builtin_cpu_supports("sse2");
+  case K_AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+#if defined(DS7505_BATCH_NEON)
+  case K_NEON:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+DS7505Batch::Kernel DS7505Batch::best()
+{
+  static const Kernel kernel =
+    supported(K_AVX2) ? K_AVX2 :
+    supported(K_NEON) ? K_NEON :
+    supported(K_SSE2) ? K_SSE2 : K_SCALAR;
+
+  return kernel;
+}
+
+const char *DS7505Batch::name(Kernel kernel)
+{
+  static const char *names[] = { "scalar", "sse2", "avx2", "neon" };
+
+  return kernel <= K_NEON ? names[kernel] : "unknown";
+}
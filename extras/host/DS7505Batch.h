@@ -0,0 +1,61 @@
+#ifndef DS7505_BATCH_H
+#define DS7505_BATCH_H
+
+#include <DS7505.h>
+#include <stddef.h>
+
+//! Bulk conversion of raw register codes on the host
+/*!
+ * For aggregators converting large arrays of codes received from boards.
+ * Results are bit-exact with DS7505::decodeTemp() and
+ * DS7505::toFahrenheit(DS7505::decodeTemp()) as built for the host, the
+ * SIMD kernels only change how many codes are converted at once.
+ */
+class DS7505Batch
+{
+
+public:
+
+  //! Output unit
+  enum Unit {
+    UNIT_C = 0x0, /*!< Celsius */
+    UNIT_F = 0x1, /*!< Fahrenheit */
+  };
+
+  //! Conversion kernels
+  enum Kernel {
+    K_SCALAR = 0x0, /*!< portable loop */
+    K_SSE2 = 0x1, /*!< x86 SSE2, 8 codes per iteration */
+    K_AVX2 = 0x2, /*!< x86 AVX2, 16 codes per iteration */
+    K_NEON = 0x3, /*!< AArch64 NEON, 8 codes per iteration */
+  };
+
+  //! Converts \ref n raw codes with the best kernel the CPU supports
+  /*!
+   * \param raw The raw register codes
+   * \param out Where to store the temperatures, may not overlap \ref raw
+   * \param n The number of codes
+   * \param unit The output unit
+   */
+  static void convertRaw(const int16_t *raw, float *out, size_t n, Unit unit)
+  {
+    convertRaw(raw, out, n, unit, best());
+  }
+
+  //! Converts \ref n raw codes with the specified kernel
+  /*!
+   * The kernel must be supported(), this is meant for benchmarks and tests.
+   */
+  static void convertRaw(const int16_t *raw, float *out, size_t n, Unit unit, Kernel kernel);
+
+  //! Whether the kernel is built in and supported by the CPU
+  static bool supported(Kernel kernel);
+
+  //! The kernel convertRaw() picks, chosen once at runtime
+  static Kernel best();
+
+  //! The kernel name
+  static const char *name(Kernel kernel);
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "DS7505Bus.h"
+
+uint8_t DS7505Bus::transfer(Message *msgs, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    Message &m = msgs[i];
+    uint8_t status = m.read ? read(m.addr, m.data, m.n) : write(m.addr, m.data, m.n);
+
+    if (status != DS7505::ST_OK)
+      return status;
+  }
+
+  return DS7505::ST_OK;
+}
+
+//while combining messages are only queued, they succeed until the batch fails
+uint8_t DS7505Bus::submitWrite(uint8_t addr, const uint8_t *data, uint8_t n)
+{
+  if (!_capturing)
+    return write(addr, data, n);
+
+  Message m;
+  m.addr = addr;
+  m.read = false;
+  m.n = n;
+  m.data = 0;
+  for (uint8_t i = 0; i < n && i < sizeof(m.buf); i++)
+    m.buf[i] = data[i];
+  _batch.push_back(m);
+
+  return DS7505::ST_OK;
+}
+
+uint8_t DS7505Bus::submitRead(uint8_t addr, uint8_t *data, uint8_t n)
+{
+  if (!_capturing)
+    return read(addr, data, n);
+
+  Message m;
+  m.addr = addr;
+  m.read = true;
+  m.n = n;
+  m.data = data;
+  _batch.push_back(m);
+
+  return DS7505::ST_OK;
+}
+
+uint8_t DS7505Bus::run(Access access, uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n, bool alone)
+{
+  Request r;
+  std::unique_lock<std::mutex> lock(_lock);
+
+  r.access = access;
+  r.addr = addr;
+  r.reg = reg;
+  r.n = n;
+  r.data = data;
+  r.alone = alone;
+  r.done = false;
+  r.next = _pending;
+#if __GNUC__ >= 12
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdangling-pointer"
+#endif
+  // unlinked by the combiner before done is set
+  _pending = &r;
+#if __GNUC__ >= 12
+#pragma GCC diagnostic pop
+#endif
+
+  // wait for a combiner to run r, or become one
+  while (!r.done) {
+    if (_busy) {
+      _idle.wait(lock);
+      continue;
+    }
+
+    Request *list = _pending;
+    _pending = 0;
+    _busy = true;
+
+    lock.unlock();
+    list = combine(list);
+    lock.lock();
+
+    // a request is on the stack of its thread, which returns once done
+    while (list) {
+      Request *next = list->next;
+      list->done = true;
+      list = next;
+    }
+
+    _busy = false;
+    _idle.notify_all();
+  }
+
+  return r.status;
+}
+
+//run the accesses queued in list, in order, in as few transfers as the alone ones allow
+DS7505Bus::Request *DS7505Bus::combine(Request *list)
+{
+  Request *fifo = 0;
+  Request *first;
+
+  while (list) {
+    Request *next = list->next;
+    list->next = fifo;
+    fifo = list;
+    list = next;
+  }
+
+  _batch.clear();
+  first = fifo;
+  for (Request *r = fifo; r; r = r->next) {
+    if (r->alone) {
+      flush(first, r);
+      r->status = r->access(r->addr, r->reg, r->data, r->n);
+      first = r->next;
+      continue;
+    }
+
+    _capturing = true;
+    r->status = r->access(r->addr, r->reg, r->data, r->n);
+    _capturing = false;
+    batched++;
+  }
+  flush(first, 0);
+
+  return fifo;
+}
+
+//send the batch of the accesses from first up to end, each run again on its own when it fails
+void DS7505Bus::flush(Request *first, Request *end)
+{
+  if (_batch.empty())
+    return;
+
+  for (size_t i = 0; i < _batch.size(); i++)
+    if (!_batch[i].read)
+      _batch[i].data = _batch[i].buf;
+
+  batches++;
+  if (transfer(_batch.data(), _batch.size()) != DS7505::ST_OK) {
+    for (uint8_t i = 0; i < 8; i++)
+      links[i].pointer = 0;
+    for (Request *r = first; r != end; r = r->next)
+      r->status = r->access(r->addr, r->reg, r->data, r->n);
+  }
+
+  _batch.clear();
+}
+
+#if defined(DS7505_STATS)
+void DS7505Bus::dumpStats(FILE *f, const char *name) const
+{
+  bool first = true;
+
+  fprintf(f, "{\"bus\": \"%s\", \"sensors\": [", name);
+
+  for (uint8_t i = 0; i < 8; i++) {
+    const DS7505::Stats &s = links[i].stats;
+
+    if (s.transactions == 0)
+      continue;
+
+    fprintf(f, "%s\n  {\"address\": %u, \"transactions\": %lu, \"bytes_written\": %lu, "
+            "\"bytes_read\": %lu, \"pointer_skips\": %lu, \"retries\": %u, \"timeouts\": %u, "
+            "\"nacks\": %u, \"latency_us_log2\": [",
+            first ? "" : ",", 0x48 | i, (unsigned long) s.transactions,
+            (unsigned long) s.bytesWritten, (unsigned long) s.bytesRead,
+            (unsigned long) s.pointerSkips, s.retries, s.timeouts, s.nacks);
+
+    for (uint8_t b = 0; b < DS7505::LATENCY_BUCKETS; b++)
+      fprintf(f, "%s%u", b ? ", " : "", s.latency[b]);
+
+    fprintf(f, "]}");
+    first = false;
+  }
+
+  fprintf(f, "\n]}\n");
+}
+#endif
@@ -0,0 +1,187 @@
+#ifndef DS7505_BUS_H
+#define DS7505_BUS_H
+
+#include "DS7505Clock.h"
+#include <DS7505.h>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+//! An I2C bus used by the driver when built on a host (Linux, simulator)
+/*!
+ * Like Wire on a board, the bus is implicit: DS7505 and DS7505Fixed talk to
+ * the bus selected for the calling thread with select(). A thread driving
+ * several buses selects each one before using its sensors.
+ *
+ * \code
+ *
+ *  DS7505SimBus bus;
+ *  DS7505Sim sim;
+ *  DS7505 ds7505;
+ *
+ *  bus.attach(0x48, &sim);
+ *  DS7505Bus::select(&bus);
+ *  ds7505.init(0, 0, 0, DS7505::RES_12);
+ *
+ * \endcode
+ *
+ * A bus is used by one thread at a time unless it is shared with
+ * setShared(true). Each register access then runs under a lock held for
+ * the whole bus, so the pointer of a sensor can't be moved by another
+ * thread between the pointer write and the read. The thread taking the
+ * lock also runs the accesses other threads queued meanwhile (flat
+ * combining) and sends all of them in one batched transfer().
+ *
+ * Host code is built with -I. -Iextras/host and needs C++11.
+ */
+class DS7505Bus
+{
+
+public:
+
+  DS7505Bus() : clock(&DS7505Clock::real()), batches(0), batched(0), links(), _shared(false), _pending(0), _busy(false), _capturing(false) {};
+
+  virtual ~DS7505Bus() {};
+
+  //! Write transaction: start, address + W, \ref n bytes, stop
+  /*!
+   * \param addr The 7 bit I2C address
+   * \param data The bytes to write
+   * \param n The number of bytes
+   * \return A DS7505::Status
+   */
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n) = 0;
+
+  //! Read transaction: start, address + R, \ref n bytes, stop
+  /*!
+   * \param addr The 7 bit I2C address
+   * \param data Where to store the bytes read
+   * \param n The number of bytes
+   * \return A DS7505::Status
+   */
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n) = 0;
+
+  //! Time source of the driver and of simulated devices on this bus
+  DS7505Clock *clock;
+
+  //! One message of a batched transfer
+  struct Message {
+    uint8_t addr;
+    bool read;
+    uint8_t n;
+    uint8_t *data; // bytes read, or written
+    uint8_t buf[4]; // copy of the bytes written
+  };
+
+  //! Runs messages back to back, with repeated starts where the bus can
+  /*!
+   * The default runs them one at a time with write() and read().
+   *
+   * \param msgs The messages
+   * \param count The number of messages
+   * \return ST_OK, or the status of the first message that failed
+   */
+  virtual uint8_t transfer(Message *msgs, size_t count);
+
+  //! Driver transport: a write, queued in the batch while combining
+  uint8_t submitWrite(uint8_t addr, const uint8_t *data, uint8_t n);
+
+  //! Driver transport: a read, queued in the batch while combining
+  uint8_t submitRead(uint8_t addr, uint8_t *data, uint8_t n);
+
+  //! A register access of the driver
+  typedef uint8_t (*Access)(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n);
+
+  //! Runs a register access under the bus lock, see setShared()
+  /*!
+   * The accesses queued by other threads are run along, in order, and
+   * their messages sent in one transfer(). When it fails the pointers are
+   * forgotten and every access of the batch is run again on its own for
+   * its status; register writes are idempotent. An access \ref alone is
+   * never batched nor run twice: the batch before it is sent first, then
+   * it runs directly on the bus, the lock held until it returns (the NV
+   * wait of a command included).
+   */
+  uint8_t run(Access access, uint8_t addr, uint8_t reg, uint8_t *data, uint8_t n, bool alone = false);
+
+  //! Lets several threads use the bus, see run()
+  void setShared(bool shared) { _shared = shared; }
+
+  //! Whether several threads may use the bus
+  bool shared() const { return _shared; }
+
+  //! Batched transfers run while combining
+  unsigned long batches;
+
+  //! Register accesses run in those batches
+  unsigned long batched;
+
+  //! Selects the bus used by the driver on the calling thread
+  static void select(DS7505Bus *bus) { selected() = bus; }
+
+  //! The bus used by the driver on the calling thread
+  static DS7505Bus *current() { return selected(); }
+
+#if defined(DS7505_STATS)
+  //! Writes the statistics of every sensor seen on this bus as JSON
+  /*!
+   * \param f The stream to write to
+   * \param name The bus name reported
+   */
+  void dumpStats(FILE *f, const char *name) const;
+#endif
+
+  //! Per address driver state (register pointer, statistics)
+  DS7505::Link links[8];
+
+private:
+  struct Request {
+    Access access;
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t n;
+    uint8_t *data;
+    uint8_t status;
+    bool alone;
+    bool done;
+    Request *next;
+  };
+
+  bool _shared;
+  std::mutex _lock; // guards _pending, _busy and done
+  std::condition_variable _idle;
+  Request *_pending; // newest first
+  bool _busy; // a thread is combining
+  std::vector<Message> _batch;
+  bool _capturing;
+
+  Request *combine(Request *list);
+  void flush(Request *first, Request *end);
+
+  static DS7505Bus *&selected()
+  {
+    static thread_local DS7505Bus *bus = 0;
+    return bus;
+  }
+};
+
+//! The clock of the selected bus, the real one when none is
+inline DS7505Clock &hostClock()
+{
+  DS7505Bus *bus = DS7505Bus::current();
+
+  return bus ? *bus->clock : DS7505Clock::real();
+}
+
+//! Host counterpart of Arduino's micros(), see DS7505Clock
+inline unsigned long micros() { return hostClock().now() / 1000; }
+
+//! Host counterpart of Arduino's millis(), see DS7505Clock
+inline unsigned long millis() { return hostClock().now() / 1000000; }
+
+//! Host counterpart of Arduino's delay(), see DS7505Clock
+inline void delay(unsigned long ms) { hostClock().sleep(ms * 1000000ull); }
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef DS7505_CLOCK_H
+#define DS7505_CLOCK_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+//! Time source of the driver on hosts
+/*!
+ * On a board the driver times itself with Arduino's micros() and
+ * delay(). On a host those read the clock of the selected bus (see
+ * DS7505Bus::clock), the real monotonic clock unless a virtual one is
+ * injected: waiting then only moves virtual time forward, so simulations
+ * spanning hours run in milliseconds and always the same way.
+ *
+ * \code
+ *
+ *  DS7505VirtualClock clock;
+ *  DS7505SimBus bus;
+ *
+ *  bus.clock = &clock; // the simulated devices convert in virtual time too
+ *  DS7505Bus::select(&bus);
+ *  ds7505.init(0, 0, 0, DS7505::RES_12);
+ *  ds7505.waitConversion(); // returns at once, 200 ms later
+ *
+ * \endcode
+ */
+class DS7505Clock
+{
+
+public:
+
+  virtual ~DS7505Clock() {};
+
+  //! Monotonic time in nanoseconds
+  virtual uint64_t now() = 0;
+
+  //! Waits \ref ns nanoseconds
+  virtual void sleep(uint64_t ns) = 0;
+
+  //! Whether the clock follows real time, event loops poll instead of sleeping then
+  virtual bool realTime() const = 0;
+
+  //! The CLOCK_MONOTONIC clock
+  static inline DS7505Clock &real();
+};
+
+//! CLOCK_MONOTONIC
+class DS7505RealClock : public DS7505Clock
+{
+
+public:
+
+  virtual uint64_t now()
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+  }
+
+  virtual void sleep(uint64_t ns)
+  {
+    struct timespec ts;
+    uint64_t t = now() + ns;
+
+    ts.tv_sec = t / 1000000000ull;
+    ts.tv_nsec = t % 1000000000ull;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR)
+      ;
+  }
+
+  virtual bool realTime() const { return true; }
+};
+
+DS7505Clock &DS7505Clock::real()
+{
+  static DS7505RealClock clock;
+
+  return clock;
+}
+
+//! Time that only moves when waited on or set
+/*!
+ * Meant for a single thread: waits by concurrent threads would add up.
+ */
+class DS7505VirtualClock : public DS7505Clock
+{
+
+public:
+
+  explicit DS7505VirtualClock(uint64_t start = 0) : _now(start) {};
+
+  virtual uint64_t now() { return _now; }
+
+  virtual void sleep(uint64_t ns) { _now += ns; }
+
+  virtual bool realTime() const { return false; }
+
+  //! Moves the time forward to \ref t, never back
+  void advance(uint64_t t) { if (t > _now) _now = t; }
+
+private:
+  uint64_t _now;
+};
+
+#endif
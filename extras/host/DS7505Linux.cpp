@@ -0,0 +1,81 @@
+#include "DS7505Linux.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+bool DS7505LinuxBus::open(const char *path)
+{
+  close();
+  _fd = ::open(path, O_RDWR | O_CLOEXEC);
+
+  return _fd >= 0;
+}
+
+void DS7505LinuxBus::close()
+{
+  if (_fd >= 0)
+    ::close(_fd);
+  _fd = -1;
+}
+
+//one I2C_RDWR ioctl, errno is mapped to a DS7505::Status
+uint8_t DS7505LinuxBus::transfer(struct i2c_msg *msgs, size_t count)
+{
+  struct i2c_rdwr_ioctl_data rdwr = { msgs, (uint32_t) count };
+
+  if (ioctl(_fd, I2C_RDWR, &rdwr) >= 0)
+    return DS7505::ST_OK;
+
+  switch (errno) {
+  case ENXIO:
+  case EREMOTEIO:
+    return DS7505::ST_NACK_ADDR;
+  case ETIMEDOUT:
+    return DS7505::ST_TIMEOUT;
+  default:
+    return DS7505::ST_ERROR;
+  }
+}
+
+//one I2C_RDWR message
+uint8_t DS7505LinuxBus::transfer(uint8_t addr, uint16_t flags, uint8_t *data, uint8_t n)
+{
+  struct i2c_msg msg = { addr, flags, n, data };
+
+  return transfer(&msg, 1);
+}
+
+uint8_t DS7505LinuxBus::transfer(Message *msgs, size_t count)
+{
+  struct i2c_msg batch[I2C_RDWR_IOCTL_MAX_MSGS];
+
+  for (size_t i = 0; i < count; ) {
+    size_t n = 0;
+
+    for (; i < count && n < I2C_RDWR_IOCTL_MAX_MSGS; i++, n++) {
+      batch[n].addr = msgs[i].addr;
+      batch[n].flags = msgs[i].read ? I2C_M_RD : 0;
+      batch[n].len = msgs[i].n;
+      batch[n].buf = msgs[i].data;
+    }
+
+    uint8_t status = transfer(batch, n);
+    if (status != DS7505::ST_OK)
+      return status;
+  }
+
+  return DS7505::ST_OK;
+}
+
+uint8_t DS7505LinuxBus::write(uint8_t addr, const uint8_t *data, uint8_t n)
+{
+  return transfer(addr, 0, (uint8_t *) data, n);
+}
+
+uint8_t DS7505LinuxBus::read(uint8_t addr, uint8_t *data, uint8_t n)
+{
+  return transfer(addr, I2C_M_RD, data, n);
+}
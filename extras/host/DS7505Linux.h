@@ -0,0 +1,43 @@
+#ifndef DS7505_LINUX_H
+#define DS7505_LINUX_H
+
+#include "DS7505Bus.h"
+
+struct i2c_msg;
+
+//! Linux i2c-dev bus (/dev/i2c-N)
+class DS7505LinuxBus : public DS7505Bus
+{
+
+public:
+
+  DS7505LinuxBus() : _fd(-1) {};
+
+  virtual ~DS7505LinuxBus() { close(); }
+
+  //! Opens the bus
+  /*!
+   * \param path The i2c-dev device, /dev/i2c-1 for instance
+   * \return true on success, errno is set otherwise
+   */
+  bool open(const char *path);
+
+  //! Closes the bus
+  void close();
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n);
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n);
+
+  //! One I2C_RDWR ioctl per 42 messages (the i2c-dev limit), repeated starts between them
+  virtual uint8_t transfer(Message *msgs, size_t count);
+
+private:
+  int _fd;
+
+  uint8_t transfer(uint8_t addr, uint16_t flags, uint8_t *data, uint8_t n);
+
+  uint8_t transfer(struct i2c_msg *msgs, size_t count);
+};
+
+#endif
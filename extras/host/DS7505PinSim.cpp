@@ -0,0 +1,149 @@
+#include "DS7505PinSim.h"
+
+void DS7505PinSlave::start(uint64_t us)
+{
+  finish();
+  _state = S_ADDR;
+  _us = us;
+  _drive = false;
+  _bit = 0;
+  _shift = 0;
+  _n = 0;
+}
+
+void DS7505PinSlave::stop()
+{
+  finish();
+  _state = S_IDLE;
+  _drive = false;
+}
+
+//a write reaches the registers once complete
+void DS7505PinSlave::finish()
+{
+  if (_state == S_WRITE)
+    _selected->write(_buf, _n);
+}
+
+void DS7505PinSlave::rise(bool sda)
+{
+  if (_state == S_IDLE || _state == S_IGNORE)
+    return;
+
+  if (_bit < 8)
+    _shift = _shift << 1 | sda;
+  else if (_state == S_READ)
+    _acked = !sda;
+  _bit++;
+}
+
+//the devices change SDA while SCL is low, after the clock of a bit
+bool DS7505PinSlave::fall()
+{
+  if (_state == S_IDLE || _state == S_IGNORE || _bit == 0)
+    return false;
+
+  if (_bit == 8) {
+    switch (_state) {
+    case S_ADDR:
+      _selected = (_shift & 0xF0) == 0x90 ? _devices[_shift >> 1 & 0x7] : 0;
+      if (!_selected) {
+        _state = S_IGNORE;
+        return false;
+      }
+      _read = _shift & 1;
+      _selected->tick(_us);
+      if (_read)
+        _selected->read(_buf, sizeof(_buf));
+      transactions++;
+      _drive = true;
+      break;
+    case S_WRITE:
+      if (_n < sizeof(_buf))
+        _buf[_n++] = _shift;
+      bytes++;
+      _drive = true;
+      break;
+    default:
+      bytes++;
+      _drive = false; // the master acknowledges
+      break;
+    }
+    return false;
+  }
+
+  if (_bit == 9) {
+    if (_state == S_ADDR) {
+      _state = _read ? S_READ : S_WRITE;
+      _acked = true;
+      _n = 0;
+    }
+    else if (_state == S_READ) {
+      _n++;
+    }
+
+    _bit = 0;
+    _shift = 0;
+    _drive = false;
+    if (_state == S_READ) {
+      if (_acked)
+        _drive = !(_buf[_n % sizeof(_buf)] & 0x80);
+      else
+        _state = S_IGNORE; // until the stop
+    }
+    return true;
+  }
+
+  if (_state == S_READ)
+    _drive = !(_buf[_n % sizeof(_buf)] >> (7 - _bit) & 1);
+
+  return false;
+}
+
+uint8_t DS7505PinSim::sdaLevels() const
+{
+  uint8_t levels = _sdaOut;
+
+  for (uint8_t i = 0; i < 8; i++)
+    if (lanes[i].sdaLow())
+      levels &= ~(1 << i);
+
+  return levels;
+}
+
+//resolve the lines, then let the devices see what changed
+void DS7505PinSim::update()
+{
+  uint64_t now = clock->now();
+  bool scl = _sclOut && now >= _stretchUntil;
+  uint8_t sda = sdaLevels();
+
+  if (scl && _sclLine) {
+    uint8_t fell = _sdaLine & ~sda, rose = sda & ~_sdaLine;
+
+    for (uint8_t i = 0; i < 8; i++) {
+      if (fell & 1 << i)
+        lanes[i].start(now / 1000);
+      else if (rose & 1 << i)
+        lanes[i].stop();
+    }
+  }
+  else if (scl && !_sclLine) {
+    clocks++;
+    for (uint8_t i = 0; i < 8; i++)
+      lanes[i].rise(sda & 1 << i);
+  }
+  else if (!scl && _sclLine) {
+    bool stretch = false;
+
+    for (uint8_t i = 0; i < 8; i++)
+      stretch |= lanes[i].fall();
+    if (stretch && stretchNs) {
+      _stretchUntil = now + stretchNs;
+      scl = false;
+    }
+  }
+
+  _sclLine = scl;
+  _sdaLine = sdaLevels();
+}
@@ -0,0 +1,217 @@
+#ifndef DS7505_PIN_SIM_H
+#define DS7505_PIN_SIM_H
+
+#include "DS7505Sim.h"
+#include <DS7505Parallel.h>
+#include <DS7505SoftI2C.h>
+
+//! The devices on one SDA line of a DS7505PinSim, seen at the pin level
+/*!
+ * Decodes start, stop and the bits clocked by the master, acknowledges
+ * the addresses of its DS7505Sim and shifts their registers out. Writes
+ * reach the register model at the stop, reads fetch it at the address.
+ */
+class DS7505PinSlave
+{
+
+public:
+
+  DS7505PinSlave() : transactions(0), bytes(0), _devices(), _selected(0), _state(S_IDLE), _drive(false) {};
+
+  //! Attaches a device at the specified address (0x48 to 0x4F)
+  void attach(uint8_t addr, DS7505Sim *device) { _devices[addr & 0x7] = device; }
+
+  //! The device attached at the specified address
+  DS7505Sim *device(uint8_t addr) const { return _devices[addr & 0x7]; }
+
+  //! Whether a device pulls SDA low
+  bool sdaLow() const { return _drive; }
+
+  //! Start condition, the devices are advanced to \ref us when addressed
+  void start(uint64_t us);
+
+  //! Stop condition
+  void stop();
+
+  //! SCL went high, SDA is \ref sda
+  void rise(bool sda);
+
+  //! SCL went low, returns whether it ended a byte
+  bool fall();
+
+  //! Transactions addressed to an attached device
+  unsigned long transactions;
+
+  //! Bytes transferred after the addresses
+  unsigned long bytes;
+
+private:
+  enum State { S_IDLE, S_IGNORE, S_ADDR, S_WRITE, S_READ };
+
+  DS7505Sim *_devices[8];
+  DS7505Sim *_selected;
+  uint64_t _us;
+  State _state;
+  bool _drive;
+  bool _read; // address + R
+  bool _acked; // master acknowledged the last byte read
+  uint8_t _bit; // clocks of the current byte seen, the 9th acknowledges
+  uint8_t _shift;
+  uint8_t _buf[8];
+  uint8_t _n;
+
+  void finish();
+};
+
+//! An open drain SCL line and up to eight SDA lines, with their devices
+/*!
+ * Each line is low while the master or a device pulls it low. Every pin
+ * access of the master costs \ref opNs of the clock, waits are the
+ * master's own; devices stretch SCL for \ref stretchNs after each byte.
+ * Meant for a DS7505VirtualClock: the achieved SCL frequency is then
+ * \ref clocks over the virtual time taken.
+ */
+class DS7505PinSim
+{
+
+public:
+
+  DS7505PinSim() : clock(&DS7505Clock::real()), opNs(0), stretchNs(0), clocks(0),
+    _sclOut(true), _sdaOut(0xFF), _sclLine(true), _sdaLine(0xFF), _stretchUntil(0) {};
+
+  //! The devices on each SDA line
+  DS7505PinSlave lanes[8];
+
+  //! Time of the lines
+  DS7505Clock *clock;
+
+  //! Cost of one pin access of the master, in ns
+  uint32_t opNs;
+
+  //! Time devices hold SCL low after each byte, in ns
+  uint32_t stretchNs;
+
+  //! SCL rising edges
+  unsigned long clocks;
+
+  //! Master side of SCL: released (true) or pulled low
+  void scl(bool released) { access(); _sclOut = released; update(); }
+
+  //! Master side of the SDA lines, bit i released for line i
+  void sda(uint8_t released) { access(); _sdaOut = released; update(); }
+
+  //! Master side of the SDA lines
+  uint8_t sdaOut() const { return _sdaOut; }
+
+  //! Level of SCL
+  bool sclLine() { access(); update(); return _sclLine; }
+
+  //! Levels of the SDA lines, bit i for line i
+  uint8_t sdaLines() { access(); update(); return _sdaLine; }
+
+private:
+  bool _sclOut;
+  uint8_t _sdaOut;
+  bool _sclLine;
+  uint8_t _sdaLine;
+  uint64_t _stretchUntil; // ns
+
+  void access() { if (opNs) clock->sleep(opNs); }
+  uint8_t sdaLevels() const;
+  void update();
+};
+
+//! One SDA line of a DS7505PinSim as the pins of DS7505SoftI2C
+class DS7505SimPins
+{
+
+public:
+
+  //! Line \ref lane of \ref wire, clocked at most at \ref hz
+  DS7505SimPins(DS7505PinSim &wire, uint32_t hz = 100000, uint8_t lane = 0)
+    : _wire(&wire), _mask(1 << lane) { setFrequency(hz); }
+
+  //! Sets the SCL frequency, 0 for no wait at all
+  void setFrequency(uint32_t hz) { _halfNs = hz ? 500000000 / hz : 0; }
+
+  void sdaLow() { _wire->sda(_wire->sdaOut() & ~_mask); }
+  void sdaRelease() { _wire->sda(_wire->sdaOut() | _mask); }
+  bool sda() const { return _wire->sdaLines() & _mask; }
+  void sclLow() { _wire->scl(false); }
+  void sclRelease() { _wire->scl(true); }
+  bool scl() const { return _wire->sclLine(); }
+  void wait() const { if (_halfNs) _wire->clock->sleep(_halfNs); }
+
+private:
+  DS7505PinSim *_wire;
+  uint8_t _mask;
+  uint32_t _halfNs;
+};
+
+//! The SDA lines of a DS7505PinSim as the port of DS7505ParallelI2C
+class DS7505SimPortPins
+{
+
+public:
+
+  //! The lines of \ref wire, clocked at most at \ref hz
+  DS7505SimPortPins(DS7505PinSim &wire, uint32_t hz = 100000) : _wire(&wire) { setFrequency(hz); }
+
+  //! Sets the SCL frequency, 0 for no wait at all
+  void setFrequency(uint32_t hz) { _halfNs = hz ? 500000000 / hz : 0; }
+
+  void sdaLow(uint8_t lanes) { _wire->sda(_wire->sdaOut() & ~lanes); }
+  void sdaRelease(uint8_t lanes) { _wire->sda(_wire->sdaOut() | lanes); }
+  uint8_t sda() const { return _wire->sdaLines(); }
+  void sclLow() { _wire->scl(false); }
+  void sclRelease() { _wire->scl(true); }
+  bool scl() const { return _wire->sclLine(); }
+  void wait() const { if (_halfNs) _wire->clock->sleep(_halfNs); }
+
+private:
+  DS7505PinSim *_wire;
+  uint32_t _halfNs;
+};
+
+//! A DS7505Bus bit-banged by DS7505SoftI2C on a DS7505PinSim
+/*!
+ * \code
+ *
+ *  DS7505VirtualClock clock;
+ *  DS7505SoftBus bus(400000);
+ *  DS7505Sim sim;
+ *
+ *  bus.clock = &clock;
+ *  bus.wire.lanes[0].attach(0x48, &sim);
+ *  DS7505Bus::select(&bus);
+ *
+ * \endcode
+ */
+class DS7505SoftBus : public DS7505Bus
+{
+
+public:
+
+  //! A bus clocked at most at \ref hz
+  explicit DS7505SoftBus(uint32_t hz = 100000) : i2c(DS7505SimPins(wire, hz)) { i2c.begin(); };
+
+  //! The lines and the devices, on line 0
+  DS7505PinSim wire;
+
+  //! The master
+  DS7505SoftI2C<DS7505SimPins> i2c;
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n)
+  {
+    wire.clock = clock;
+    return i2c.write(addr, data, n);
+  }
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n)
+  {
+    wire.clock = clock;
+    return i2c.read(addr, data, n);
+  }
+};
+
+#endif
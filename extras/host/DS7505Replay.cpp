@@ -0,0 +1,203 @@
+#include "DS7505Replay.h"
+#include <string.h>
+
+static const char MAGIC[] = "DS7505T1";
+
+static void putVarint(FILE *f, unsigned long v)
+{
+  while (v >= 0x80) {
+    fputc((int) (v & 0x7F) | 0x80, f);
+    v >>= 7;
+  }
+  fputc((int) v, f);
+}
+
+static bool getVarint(FILE *f, unsigned long &v)
+{
+  int c;
+  unsigned shift = 0;
+
+  v = 0;
+  do {
+    if ((c = fgetc(f)) == EOF || shift > 56)
+      return false;
+    v |= (unsigned long) (c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+
+  return true;
+}
+
+bool DS7505RecordBus::open(const char *path)
+{
+  close();
+
+  if (!(_file = fopen(path, "wb")))
+    return false;
+
+  fwrite(MAGIC, 1, 8, _file);
+  _last = micros();
+
+  return true;
+}
+
+void DS7505RecordBus::close()
+{
+  if (_file)
+    fclose(_file);
+  _file = 0;
+}
+
+void DS7505RecordBus::record(bool rd, uint8_t addr, const uint8_t *data, uint8_t n,
+                             uint8_t status, unsigned long start)
+{
+  if (!_file)
+    return;
+
+  fputc((rd ? 0x80 : 0) | (addr & 0x7F), _file);
+  fputc(n, _file);
+  fputc(status, _file);
+  putVarint(_file, start - _last);
+  putVarint(_file, micros() - start);
+  fwrite(data, 1, n, _file);
+
+  _last = start;
+}
+
+uint8_t DS7505RecordBus::write(uint8_t addr, const uint8_t *data, uint8_t n)
+{
+  unsigned long start = micros();
+  uint8_t status = _bus->write(addr, data, n);
+
+  record(false, addr, data, n, status, start);
+
+  return status;
+}
+
+uint8_t DS7505RecordBus::read(uint8_t addr, uint8_t *data, uint8_t n)
+{
+  unsigned long start = micros();
+  uint8_t status = _bus->read(addr, data, n);
+
+  record(true, addr, data, n, status, start);
+
+  return status;
+}
+
+bool DS7505ReplayBus::load(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  char magic[8];
+  uint8_t pointers[8] = { 0 };
+  unsigned long totalUs = 0, totalBytes = 0;
+  int op;
+
+  if (!f)
+    return false;
+
+  if (fread(magic, 1, 8, f) != 8 || memcmp(magic, MAGIC, 8) != 0) {
+    fclose(f);
+    return false;
+  }
+
+  _addresses.clear();
+  for (uint8_t i = 0; i < 8; i++)
+    _samples[i].clear();
+
+  while ((op = fgetc(f)) != EOF) {
+    int n = fgetc(f);
+    int status = fgetc(f);
+    unsigned long start, duration;
+    uint8_t data[256];
+    uint8_t addr = op & 0x7F;
+
+    if (n == EOF || status == EOF || !getVarint(f, start) || !getVarint(f, duration)
+        || fread(data, 1, n, f) != (size_t) n)
+      break;
+
+    totalUs += duration;
+    totalBytes += 1 + n;
+
+    if (status != DS7505::ST_OK || (addr & 0x78) != 0x48)
+      continue;
+
+    uint8_t i = addr & 0x7;
+    bool seen = false;
+    for (size_t a = 0; a < _addresses.size(); a++)
+      seen |= _addresses[a] == addr;
+    if (!seen)
+      _addresses.push_back(addr);
+
+    if (!(op & 0x80)) {
+      if (n > 0 && data[0] <= DS7505::P_TOS)
+        pointers[i] = data[0];
+    }
+    else if (pointers[i] == DS7505::P_TEMP && n >= 2) {
+      _samples[i].push_back((int16_t) (data[0] << 8 | data[1]));
+    }
+  }
+
+  fclose(f);
+
+  _usPerByte = totalBytes ? (double) totalUs / totalBytes : 0;
+  rewind();
+
+  return true;
+}
+
+void DS7505ReplayBus::rewind()
+{
+  transactions = 0;
+  bytes = 0;
+  busTimeUs = 0;
+
+  for (uint8_t i = 0; i < 8; i++) {
+    _next[i] = 0;
+    _devices[i] = DS7505Sim();
+    links[i] = DS7505::Link();
+  }
+}
+
+bool DS7505ReplayBus::done() const
+{
+  for (uint8_t i = 0; i < 8; i++)
+    if (_next[i] < _samples[i].size())
+      return false;
+
+  return true;
+}
+
+uint8_t DS7505ReplayBus::write(uint8_t addr, const uint8_t *data, uint8_t n)
+{
+  transactions++;
+  bytes += 1 + n;
+  busTimeUs += _usPerByte * (1 + n);
+
+  if ((addr & 0x78) != 0x48 || _samples[addr & 0x7].empty())
+    return DS7505::ST_NACK_ADDR;
+
+  return _devices[addr & 0x7].write(data, n);
+}
+
+uint8_t DS7505ReplayBus::read(uint8_t addr, uint8_t *data, uint8_t n)
+{
+  uint8_t i = addr & 0x7;
+
+  transactions++;
+  bytes += 1 + n;
+  busTimeUs += _usPerByte * (1 + n);
+
+  if ((addr & 0x78) != 0x48 || _samples[i].empty())
+    return DS7505::ST_NACK_ADDR;
+
+  if (_devices[i].pointer() != DS7505::P_TEMP)
+    return _devices[i].read(data, n);
+
+  // past the end of the trace the last temperature is repeated
+  int16_t raw = _samples[i][_next[i] < _samples[i].size() ? _next[i]++ : _samples[i].size() - 1];
+
+  for (uint8_t b = 0; b < n; b++)
+    data[b] = (b & 1) ? (uint8_t) raw : (uint8_t) (raw >> 8);
+
+  return DS7505::ST_OK;
+}
@@ -0,0 +1,113 @@
+#ifndef DS7505_REPLAY_H
+#define DS7505_REPLAY_H
+
+#include "DS7505Sim.h"
+#include <vector>
+
+/*
+ * Bus trace format, little endian, one record per transaction:
+ *
+ *   "DS7505T1"                       file header
+ *   [R addr6..0] [n] [status]        R set for reads
+ *   varint start                     us since the previous record start
+ *   varint duration                  us
+ *   n data bytes                     written or read
+ *
+ * varints are unsigned LEB128 (7 bits per byte, LSB first).
+ */
+
+//! Records the raw transactions of another bus to a binary trace
+class DS7505RecordBus : public DS7505Bus
+{
+
+public:
+
+  DS7505RecordBus(DS7505Bus *bus) : _bus(bus), _file(0), _last(0) {};
+
+  virtual ~DS7505RecordBus() { close(); }
+
+  //! Opens the trace file
+  /*!
+   * \param path The trace to write
+   * \return true on success
+   */
+  bool open(const char *path);
+
+  //! Closes the trace file
+  void close();
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n);
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n);
+
+private:
+  DS7505Bus *_bus;
+  FILE *_file;
+  unsigned long _last;
+
+  void record(bool rd, uint8_t addr, const uint8_t *data, uint8_t n, uint8_t status,
+              unsigned long start);
+};
+
+//! Replays a recorded trace to the driver
+/*!
+ * Every device seen in the trace is modelled by a DS7505Sim, so writes and
+ * reads of the configuration and thermostat registers behave as on the
+ * device, and each read of the temperature register returns the next
+ * temperature recorded for that address. The driver may issue a different
+ * transaction sequence than the one recorded (skipped pointer writes,
+ * batching, ...) and still see the same temperatures, which makes runs of
+ * different driver versions comparable.
+ *
+ * Bus time is modelled from the recorded traffic: every transaction costs
+ * the average time per byte seen in the trace times its bytes on the wire
+ * (address included).
+ */
+class DS7505ReplayBus : public DS7505Bus
+{
+
+public:
+
+  DS7505ReplayBus() : transactions(0), bytes(0), busTimeUs(0), _usPerByte(0) {};
+
+  //! Loads a trace
+  /*!
+   * \param path The trace written by DS7505RecordBus
+   * \return true on success
+   */
+  bool load(const char *path);
+
+  //! Restarts the replay from the first recorded temperature
+  void rewind();
+
+  //! Addresses of the devices seen in the trace
+  const std::vector<uint8_t> &addresses() const { return _addresses; }
+
+  //! The number of temperatures recorded for the specified address
+  size_t samples(uint8_t addr) const { return _samples[addr & 0x7].size(); }
+
+  //! Whether every recorded temperature was read back
+  bool done() const;
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n);
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n);
+
+  //! Transactions issued by the driver during the replay
+  unsigned long transactions;
+
+  //! Bytes on the wire during the replay, address bytes included
+  unsigned long bytes;
+
+  //! Modelled bus time of the replay
+  double busTimeUs;
+
+private:
+  double _usPerByte;
+  std::vector<uint8_t> _addresses;
+  std::vector<int16_t> _samples[8];
+  size_t _next[8];
+  DS7505Sim _devices[8];
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "DS7505Sim.h"
+#include <math.h>
+
+DS7505Plant::DS7505Plant(float ambient, float tau, uint32_t seed)
+  : ambient(ambient), tau(tau), drift(0), period(86400), noise(0),
+    _temp(ambient), _time(0), _rng(seed ? seed * 2654435761u : 1)
+{
+}
+
+void DS7505Plant::addSource(float start, float end, float delta)
+{
+  Event e = { start, end, delta };
+  _events.push_back(e);
+}
+
+void DS7505Plant::addStep(float t, float delta)
+{
+  addSource(t, INFINITY, delta);
+}
+
+float DS7505Plant::equilibrium(float t) const
+{
+  float e = ambient;
+
+  if (drift != 0)
+    e += drift * sinf(6.2831853f * fmodf(t, period) / period);
+
+  for (size_t i = 0; i < _events.size(); i++)
+    if (t >= _events[i].start && t < _events[i].end)
+      e += _events[i].delta;
+
+  return e;
+}
+
+//first order lag, the equilibrium held at its value at the end of the step
+float DS7505Plant::temp(uint64_t us)
+{
+  if (us > _time) {
+    float dt = (us - _time) / 1e6f;
+    _temp += (equilibrium(us / 1e6f) - _temp) * (1 - expf(-dt / tau));
+    _time = us;
+  }
+
+  return _temp;
+}
+
+float DS7505Plant::sample(uint64_t us)
+{
+  float t = temp(us);
+
+  return noise != 0 ? t + noise * gaussian() : t;
+}
+
+//xorshift32 and Box-Muller, cheap and reproducible; the seed is spread
+//over the word (see the constructor), small ones would start far out
+float DS7505Plant::gaussian()
+{
+  float u[2];
+
+  for (int i = 0; i < 2; i++) {
+    _rng ^= _rng << 13;
+    _rng ^= _rng >> 17;
+    _rng ^= _rng << 5;
+    u[i] = (_rng >> 8) * (1.0f / 16777216.0f);
+  }
+
+  return sqrtf(-2 * logf(u[0] + 1e-12f)) * cosf(6.2831853f * u[1]);
+}
+
+// Power-up defaults: 9 bit, comparator mode, TOS 80, THYST 75
+DS7505Sim::DS7505Sim()
+  : _temp(25.0), _plant(0), _converted(0), _pointer(DS7505::P_TEMP),
+    _nvConfig(0), _nvThyst(75 << 8), _nvTos(80 << 8)
+{
+  recall();
+  resetThermostat();
+}
+
+void DS7505Sim::recall()
+{
+  _config = _nvConfig;
+  _thyst = _nvThyst;
+  _tos = _nvTos;
+}
+
+void DS7505Sim::tick(uint64_t us)
+{
+  DS7505::Config config(_config);
+
+  if (!_plant)
+    return;
+
+  // conversions start over after a shutdown
+  if (config.shutdown()) {
+    _converted = 0;
+    return;
+  }
+
+  uint64_t period = DS7505::conversionTimeMs(config.resolution()) * 1000ull;
+  uint64_t last = us - us % period;
+  bool latched = config.mode() == DS7505::MODE_INTERRUPT && _os;
+
+  if (last <= _converted && _converted != 0)
+    return;
+
+  // every conversion counts towards the fault tolerance
+  for (uint64_t t = _converted == 0 || latched ? last : _converted + period; t <= last; t += period) {
+    _temp = _plant->sample(t);
+    thermostat();
+  }
+  _converted = last;
+}
+
+//compare a conversion with the limit the output waits for
+void DS7505Sim::thermostat()
+{
+  static const uint8_t faults[] = { 1, 2, 4, 6 };
+  DS7505::Config config(_config);
+  bool comparator = config.mode() == DS7505::MODE_COMPARATOR;
+
+  // an interrupt stays latched until read
+  if (!comparator && _os)
+    return;
+
+  bool up = comparator ? !_os : !_armedLow;
+  int16_t t = raw(DS7505::P_TEMP);
+
+  if (up ? t >= _tos : t < _thyst)
+    _faults++;
+  else
+    _faults = 0;
+
+  if (_faults < faults[config.faultTolerance()])
+    return;
+
+  _faults = 0;
+  if (comparator) {
+    _os = up;
+  }
+  else {
+    _os = true;
+    _armedLow = up;
+  }
+}
+
+int16_t DS7505Sim::raw(DS7505::Register reg) const
+{
+  switch (reg) {
+  case DS7505::P_TEMP:
+    return DS7505::encodeTemp(_temp, DS7505::Config(_config).resolution());
+  case DS7505::P_THYST:
+    return _thyst;
+  case DS7505::P_TOS:
+    return _tos;
+  default:
+    return (int16_t) (_config << 8 | _config);
+  }
+}
+
+uint8_t DS7505Sim::write(const uint8_t *data, uint8_t n)
+{
+  if (n == 0)
+    return DS7505::ST_OK;
+
+  switch (data[0]) {
+  case DS7505::CMD_RECALL_DATA:
+    recall();
+    resetThermostat();
+    return DS7505::ST_OK;
+  case DS7505::CMD_COPY_DATA:
+    _nvConfig = _config;
+    _nvThyst = _thyst;
+    _nvTos = _tos;
+    return DS7505::ST_OK;
+  case DS7505::CMD_POR:
+    recall();
+    resetThermostat();
+    _pointer = DS7505::P_TEMP;
+    return DS7505::ST_OK;
+  }
+
+  if (data[0] > DS7505::P_TOS)
+    return DS7505::ST_NACK_DATA;
+
+  _pointer = data[0];
+
+  // the LSBs below the 12 bit resolution always read back as 0
+  switch (_pointer) {
+  case DS7505::P_CONF:
+    if (n > 1) {
+      uint8_t changed = (_config ^ data[1]) & 0x02;
+
+      _config = (_config & 0x80) | (data[1] & 0x7F);
+      // a new mode or a shutdown starts the thermostat over
+      if (changed || (_config & 0x01))
+        resetThermostat();
+    }
+    break;
+  case DS7505::P_THYST:
+    if (n > 2)
+      _thyst = (int16_t) (data[1] << 8 | (data[2] & 0xF0));
+    break;
+  case DS7505::P_TOS:
+    if (n > 2)
+      _tos = (int16_t) (data[1] << 8 | (data[2] & 0xF0));
+    break;
+  }
+
+  return DS7505::ST_OK;
+}
+
+uint8_t DS7505Sim::read(uint8_t *data, uint8_t n)
+{
+  int16_t r = raw((DS7505::Register) _pointer);
+
+  if (DS7505::Config(_config).mode() == DS7505::MODE_INTERRUPT)
+    _os = false;
+
+  for (uint8_t i = 0; i < n; i++)
+    data[i] = (i & 1) ? (uint8_t) r : (uint8_t) (r >> 8);
+
+  return DS7505::ST_OK;
+}
+
+uint8_t DS7505SimBus::write(uint8_t addr, const uint8_t *data, uint8_t n)
+{
+  DS7505Sim *device = lookup(addr);
+
+  transactions++;
+  bytes += 1 + n;
+
+  if (!device)
+    return DS7505::ST_NACK_ADDR;
+
+  device->tick(clock->now() / 1000);
+  return device->write(data, n);
+}
+
+uint8_t DS7505SimBus::read(uint8_t addr, uint8_t *data, uint8_t n)
+{
+  DS7505Sim *device = lookup(addr);
+
+  transactions++;
+  bytes += 1 + n;
+
+  if (!device)
+    return DS7505::ST_NACK_ADDR;
+
+  device->tick(clock->now() / 1000);
+  return device->read(data, n);
+}
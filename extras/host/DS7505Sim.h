@@ -0,0 +1,197 @@
+#ifndef DS7505_SIM_H
+#define DS7505_SIM_H
+
+#include "DS7505Bus.h"
+#include <vector>
+
+//! Thermal plant seen by a simulated sensor
+/*!
+ * The temperature follows a first order lag (time constant tau) towards
+ * an equilibrium made of the ambient temperature, a sine drift, permanent
+ * steps and heat sources switched on for a while. Each conversion samples
+ * it with gaussian noise. The plant is advanced lazily in closed form,
+ * the equilibrium held over each step at its value at the end of it, so
+ * a sample costs the same however long since the previous one. A
+ * DS7505Sim still takes one per conversion, see DS7505Sim::tick().
+ *
+ * \code
+ *
+ *  DS7505Plant room(21.0f, 900.0f);
+ *  room.drift = 2.0f; // +-2 C over a day
+ *  room.noise = 0.05f;
+ *  room.addSource(3600, 5400, 4.0f); // a heater for half an hour
+ *  room.addStep(7200, -3.0f); // a window left open
+ *  sim.setPlant(&room);
+ *  sim.tick(t); // conversions up to t, in us
+ *
+ * \endcode
+ */
+class DS7505Plant
+{
+
+public:
+
+  //! Builds a plant at equilibrium
+  /*!
+   * \param ambient The ambient temperature in Celsius
+   * \param tau The thermal time constant in seconds
+   * \param seed The seed of the noise generator
+   */
+  DS7505Plant(float ambient = 22.0f, float tau = 600.0f, uint32_t seed = 1);
+
+  //! Ambient temperature in Celsius
+  float ambient;
+
+  //! Thermal time constant in seconds
+  float tau;
+
+  //! Amplitude of the sine drift of the ambient temperature in Celsius
+  float drift;
+
+  //! Period of the drift in seconds, a day by default
+  float period;
+
+  //! Standard deviation of the measurement noise in Celsius
+  float noise;
+
+  //! Adds a heat source raising the equilibrium by \ref delta from \ref start to \ref end (s)
+  void addSource(float start, float end, float delta);
+
+  //! Adds a permanent step of \ref delta to the ambient temperature at \ref t (s)
+  void addStep(float t, float delta);
+
+  //! The temperature at time \ref us, which must not go back in time
+  float temp(uint64_t us);
+
+  //! A noisy measurement at time \ref us
+  float sample(uint64_t us);
+
+private:
+  struct Event {
+    float start;
+    float end;
+    float delta;
+  };
+
+  std::vector<Event> _events;
+  float _temp;
+  uint64_t _time; // us
+  uint32_t _rng;
+
+  float equilibrium(float t) const;
+  float gaussian();
+};
+
+//! Register level model of one DS7505
+/*!
+ * Models the pointer, configuration, TOS/THYST (with their NV copies) and
+ * temperature registers, and the command set. The temperature register
+ * holds setTemp() quantised at the configured resolution.
+ *
+ * The thermostat output follows every conversion (and every setTemp()):
+ * in comparator mode O.S. is active from TOS down to THYST, in interrupt
+ * mode it latches when the armed limit is crossed, until a register is
+ * read or the device shut down, and the other limit is armed next. Both
+ * honour the fault tolerance.
+ */
+class DS7505Sim
+{
+
+public:
+
+  DS7505Sim();
+
+  //! Sets the temperature the device measures, in Celsius, as a conversion would
+  void setTemp(float t) { _temp = t; thermostat(); }
+
+  //! The temperature the device measures, in Celsius
+  float temp() const { return _temp; }
+
+  //! The configuration register
+  uint8_t config() const { return _config; }
+
+  //! The register pointer
+  uint8_t pointer() const { return _pointer; }
+
+  //! Whether the O.S. output is active, whatever its polarity
+  bool os() const { return _os; }
+
+  //! A raw temperature register (P_TEMP, P_THYST or P_TOS)
+  int16_t raw(DS7505::Register reg) const;
+
+  //! Bus side of a write transaction addressed to the device
+  uint8_t write(const uint8_t *data, uint8_t n);
+
+  //! Bus side of a read transaction addressed to the device
+  uint8_t read(uint8_t *data, uint8_t n);
+
+  //! Samples the temperature from a plant at every conversion, see tick()
+  void setPlant(DS7505Plant *plant) { _plant = plant; }
+
+  //! Advances the device to time \ref us
+  /*!
+   * DS7505SimBus calls it with the time of its clock on every transaction.
+   *
+   * The temperature register gets the plant sampled at the last
+   * conversion completed, conversions running back to back every
+   * DS7505::conversionTimeMs() unless shut down. The thermostat sees each
+   * of the conversions completed since the previous tick: the fault
+   * tolerance counts consecutive conversions and an excursion between two
+   * reads must still trip O.S. The plant is therefore sampled at every
+   * conversion, however sparse the ticks: under 100 ns each, some 30 ms
+   * per simulated day of a 12 bit sensor. Only a latched interrupt, blind to
+   * conversions until read, skips to the last one.
+   */
+  void tick(uint64_t us);
+
+private:
+  float _temp;
+  DS7505Plant *_plant;
+  uint64_t _converted; // us, last conversion
+  uint8_t _pointer;
+  uint8_t _config;
+  int16_t _thyst;
+  int16_t _tos;
+  uint8_t _nvConfig;
+  int16_t _nvThyst;
+  int16_t _nvTos;
+  bool _os; // O.S. active
+  bool _armedLow; // interrupt mode, waiting for THYST
+  uint8_t _faults; // consecutive conversions past the limit watched
+
+  void recall();
+  void thermostat();
+  void resetThermostat() { _os = false; _armedLow = false; _faults = 0; }
+};
+
+//! Simulated bus holding up to eight DS7505Sim
+class DS7505SimBus : public DS7505Bus
+{
+
+public:
+
+  DS7505SimBus() : transactions(0), bytes(0), _devices() {};
+
+  //! Attaches a device at the specified address (0x48 to 0x4F)
+  void attach(uint8_t addr, DS7505Sim *device) { _devices[addr & 0x7] = device; }
+
+  //! The device attached at the specified address
+  DS7505Sim *device(uint8_t addr) const { return _devices[addr & 0x7]; }
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n);
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n);
+
+  //! Transactions seen on the bus
+  unsigned long transactions;
+
+  //! Bytes transferred on the bus, address bytes included
+  unsigned long bytes;
+
+private:
+  DS7505Sim *_devices[8];
+
+  DS7505Sim *lookup(uint8_t addr) const { return (addr & 0x78) == 0x48 ? _devices[addr & 0x7] : 0; }
+};
+
+#endif
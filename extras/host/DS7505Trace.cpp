@@ -0,0 +1,150 @@
+#include "DS7505Trace.h"
+
+DS7505TraceBus::DS7505TraceBus(DS7505Bus *bus, unsigned track, unsigned capacity)
+  : _bus(bus), _track(track), _capacity(capacity), _records(new Record[capacity]),
+    _head(0), _tail(0), _dropped(0), _file(0), _first(true), _pointers()
+{
+  clock = bus->clock;
+}
+
+DS7505TraceBus::~DS7505TraceBus()
+{
+  close();
+  delete[] _records;
+}
+
+bool DS7505TraceBus::open(const char *path)
+{
+  close();
+
+  _file = fopen(path, "w");
+  _first = true;
+
+  if (_file)
+    fprintf(_file, "[\n");
+
+  return _file != 0;
+}
+
+void DS7505TraceBus::close()
+{
+  if (!_file)
+    return;
+
+  flush();
+  fprintf(_file, "\n]\n");
+  fclose(_file);
+  _file = 0;
+}
+
+//single producer (the bus user), single consumer (flush)
+void DS7505TraceBus::record(uint8_t event, const char *name, uint8_t addr, uint8_t pointer,
+                            uint8_t count, uint8_t status, uint64_t start)
+{
+  unsigned head = _head.load(std::memory_order_relaxed);
+
+  if (head - _tail.load(std::memory_order_acquire) == _capacity) {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Record &r = _records[head % _capacity];
+  r.start = start;
+  r.end = event <= EV_READ ? now() : start;
+  r.name = name;
+  r.event = event;
+  r.addr = addr;
+  r.pointer = pointer;
+  r.count = count;
+  r.status = status;
+
+  _head.store(head + 1, std::memory_order_release);
+}
+
+//name of a write transaction from its first byte
+static const char *writeName(uint8_t first)
+{
+  switch (first) {
+  case DS7505::P_TEMP: return "write P_TEMP";
+  case DS7505::P_CONF: return "write P_CONF";
+  case DS7505::P_THYST: return "write P_THYST";
+  case DS7505::P_TOS: return "write P_TOS";
+  case DS7505::CMD_RECALL_DATA: return "CMD_RECALL_DATA";
+  case DS7505::CMD_COPY_DATA: return "CMD_COPY_DATA";
+  case DS7505::CMD_POR: return "CMD_POR";
+  default: return "write";
+  }
+}
+
+static const char *readName(uint8_t pointer)
+{
+  switch (pointer) {
+  case DS7505::P_TEMP: return "read P_TEMP";
+  case DS7505::P_CONF: return "read P_CONF";
+  case DS7505::P_THYST: return "read P_THYST";
+  case DS7505::P_TOS: return "read P_TOS";
+  default: return "read";
+  }
+}
+
+uint8_t DS7505TraceBus::write(uint8_t addr, const uint8_t *data, uint8_t n)
+{
+  uint64_t start = now();
+  uint8_t status = _bus->write(addr, data, n);
+  uint8_t first = n ? data[0] : 0xFF;
+
+  if (status == DS7505::ST_OK && first <= DS7505::P_TOS)
+    _pointers[addr & 0x7] = first;
+
+  record(EV_WRITE, writeName(first), addr, first, n, status, start);
+
+  return status;
+}
+
+uint8_t DS7505TraceBus::read(uint8_t addr, uint8_t *data, uint8_t n)
+{
+  uint64_t start = now();
+  uint8_t status = _bus->read(addr, data, n);
+  uint8_t pointer = _pointers[addr & 0x7];
+
+  record(EV_READ, readName(pointer), addr, pointer, n, status, start);
+
+  return status;
+}
+
+unsigned DS7505TraceBus::flush()
+{
+  unsigned tail = _tail.load(std::memory_order_relaxed);
+  unsigned head = _head.load(std::memory_order_acquire);
+  unsigned written = 0;
+
+  for (; tail != head; tail++, written++) {
+    const Record &r = _records[tail % _capacity];
+
+    if (!_file)
+      continue;
+
+    fprintf(_file, "%s", _first ? "" : ",\n");
+    _first = false;
+
+    if (r.event == EV_BEGIN || r.event == EV_END) {
+      fprintf(_file, "{\"name\": \"%s\", \"cat\": \"ds7505\", \"ph\": \"%s\", \"ts\": %.3f, "
+              "\"pid\": 1, \"tid\": %u}",
+              r.name, r.event == EV_BEGIN ? "B" : "E", r.start / 1000.0, _track);
+      continue;
+    }
+
+    fprintf(_file, "{\"name\": \"%s\", \"cat\": \"ds7505\", \"ph\": \"X\", \"ts\": %.3f, "
+            "\"dur\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"addr\": \"0x%02x\", "
+            "\"pointer\": %u, \"bytes\": %u, \"status\": %u}}",
+            r.name, r.start / 1000.0, (r.end - r.start) / 1000.0, _track,
+            r.addr, r.pointer, r.count, r.status);
+  }
+
+  _tail.store(tail, std::memory_order_release);
+
+  if (_file)
+    fflush(_file);
+
+  return written;
+}
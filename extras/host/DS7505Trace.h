@@ -0,0 +1,117 @@
+#ifndef DS7505_TRACE_H
+#define DS7505_TRACE_H
+
+#include "DS7505Bus.h"
+#include <atomic>
+
+//! Records the transactions of another bus as Chrome trace events
+/*!
+ * Wraps a DS7505LinuxBus or DS7505SimBus and records every transaction
+ * (start/end time, address, register pointer, byte count, status) in a
+ * buffer allocated up front. flush() turns the recorded events into Chrome
+ * trace-event JSON, loadable in chrome://tracing or ui.perfetto.dev.
+ *
+ * Times come from the clock of the recorded bus, so a simulation in
+ * virtual time (see DS7505VirtualClock) traces in virtual time too; the
+ * trace bus starts out on that clock for the waits of the driver.
+ *
+ * Recording never allocates nor does I/O, events are dropped (and counted)
+ * when the buffer is full. flush() may run on another thread than the one
+ * using the bus, so a low priority thread can drain the buffer.
+ *
+ * \code
+ *
+ *  DS7505LinuxBus i2c;
+ *  DS7505TraceBus bus(&i2c, 1);
+ *
+ *  i2c.open("/dev/i2c-1");
+ *  bus.open("ds7505.json");
+ *  DS7505Bus::select(&bus);
+ *
+ *  bus.begin("sweep");
+ *  // ... read sensors
+ *  bus.end("sweep");
+ *
+ *  bus.flush();
+ *
+ * \endcode
+ */
+class DS7505TraceBus : public DS7505Bus
+{
+
+public:
+
+  //! Constructor
+  /*!
+   * \param bus The bus to record
+   * \param track The trace thread id the bus is shown as
+   * \param capacity The number of events buffered between flushes
+   */
+  DS7505TraceBus(DS7505Bus *bus, unsigned track = 0, unsigned capacity = 65536);
+
+  virtual ~DS7505TraceBus();
+
+  //! Opens the trace file
+  /*!
+   * \param path The JSON file to write
+   * \return true on success
+   */
+  bool open(const char *path);
+
+  //! Flushes the remaining events and terminates the JSON document
+  void close();
+
+  //! Writes the events recorded so far to the trace file
+  /*!
+   * \return The number of events written
+   */
+  unsigned flush();
+
+  //! Starts a named slice (a sweep, a conversion wait, ...)
+  /*!
+   * \param name A string that outlives the trace, usually a literal
+   */
+  void begin(const char *name) { record(EV_BEGIN, name, 0, 0, 0, 0, now()); }
+
+  //! Ends the slice started by begin()
+  void end(const char *name) { record(EV_END, name, 0, 0, 0, 0, now()); }
+
+  //! The number of events dropped because the buffer was full
+  unsigned long dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n);
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n);
+
+private:
+  enum Event { EV_WRITE, EV_READ, EV_BEGIN, EV_END };
+
+  struct Record {
+    uint64_t start; // ns
+    uint64_t end; // ns
+    const char *name;
+    uint8_t event;
+    uint8_t addr;
+    uint8_t pointer;
+    uint8_t count;
+    uint8_t status;
+  };
+
+  DS7505Bus *_bus;
+  unsigned _track;
+  unsigned _capacity;
+  Record *_records;
+  std::atomic<unsigned> _head; // next record written
+  std::atomic<unsigned> _tail; // next record flushed
+  std::atomic<unsigned long> _dropped;
+  FILE *_file;
+  bool _first;
+  uint8_t _pointers[8];
+
+  uint64_t now() { return _bus->clock->now(); }
+
+  void record(uint8_t event, const char *name, uint8_t addr, uint8_t pointer,
+              uint8_t count, uint8_t status, uint64_t start);
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "DS7505Shm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//a fresh object: truncating the old one would fault the readers still mapping it
+bool DS7505ShmTable::create(const char *name, unsigned buses)
+{
+  close();
+
+  if (shm_unlink(name) < 0 && errno != ENOENT)
+    return false;
+
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0)
+    return false;
+
+  _size = DS7505Table::size(buses);
+  if (ftruncate(fd, _size) < 0) {
+    ::close(fd);
+    return false;
+  }
+
+  _memory = mmap(0, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (_memory == MAP_FAILED) {
+    _memory = 0;
+    return false;
+  }
+
+  _table.create(_memory, buses);
+
+  return true;
+}
+
+bool DS7505ShmTable::open(const char *name)
+{
+  struct stat st;
+
+  close();
+
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+
+  if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(DS7505Table::Header)) {
+    ::close(fd);
+    errno = EPROTO;
+    return false;
+  }
+
+  _name = name;
+  _ino = st.st_ino;
+  _size = st.st_size;
+  _memory = mmap(0, _size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (_memory == MAP_FAILED) {
+    _memory = 0;
+    return false;
+  }
+
+  if (!_table.attach(_memory) || DS7505Table::size(_table.buses()) > _size) {
+    close();
+    errno = EPROTO;
+    return false;
+  }
+
+  return true;
+}
+
+//the name now leads to another object, or to none
+bool DS7505ShmTable::stale() const
+{
+  struct stat st;
+
+  if (_name.empty())
+    return false;
+
+  int fd = shm_open(_name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    return true;
+
+  bool replaced = fstat(fd, &st) < 0 || st.st_ino != _ino;
+  ::close(fd);
+
+  return replaced;
+}
+
+void DS7505ShmTable::close()
+{
+  if (_memory)
+    munmap(_memory, _size);
+  _memory = 0;
+  _size = 0;
+  _name.clear();
+  _ino = 0;
+  _table = DS7505Table();
+}
@@ -0,0 +1,77 @@
+#ifndef DS7505_SHM_H
+#define DS7505_SHM_H
+
+#include "DS7505Table.h"
+#include <string>
+#include <sys/types.h>
+
+//! A DS7505Table in POSIX shared memory (/dev/shm)
+/*!
+ * The daemon creates the table, any number of processes open it read-only
+ * and poll the latest readings with plain loads: no syscall, no bus access.
+ *
+ * A restarted daemon unlinks the table and creates a fresh one: readers
+ * keep a valid mapping of the old one, whose readings stop changing, and
+ * check stale() now and then to open the new one.
+ *
+ * \code
+ *
+ *  DS7505ShmTable shm;
+ *
+ *  if (shm.open("/ds7505")) {
+ *    DS7505Snapshot s = shm.table().read(0, 0x48);
+ *    printf("%f\n", DS7505::decodeTemp(s.raw));
+ *  }
+ *
+ *  // ... later
+ *  if (shm.stale())
+ *    shm.open("/ds7505");
+ *
+ * \endcode
+ */
+class DS7505ShmTable
+{
+
+public:
+
+  DS7505ShmTable() : _memory(0), _size(0), _ino(0) {};
+
+  ~DS7505ShmTable() { close(); }
+
+  //! Creates (or replaces) the table, for the writer
+  /*!
+   * A table of the same name is unlinked, not reused, see stale().
+   * \param name The shared memory object, "/ds7505" for /dev/shm/ds7505
+   * \param buses The number of buses
+   * \return true on success, errno is set otherwise
+   */
+  bool create(const char *name, unsigned buses);
+
+  //! Maps an existing table read-only, for readers
+  /*!
+   * \param name The shared memory object
+   * \return true on success, errno is set (EPROTO for an incompatible table)
+   */
+  bool open(const char *name);
+
+  //! Whether the table opened was replaced or removed since, for readers
+  /*!
+   * One shm_open() and fstat(), not meant for every read.
+   */
+  bool stale() const;
+
+  //! Unmaps the table
+  void close();
+
+  DS7505Table &table() { return _table; }
+  const DS7505Table &table() const { return _table; }
+
+private:
+  void *_memory;
+  size_t _size;
+  std::string _name; // opened by a reader
+  ino_t _ino;
+  DS7505Table _table;
+};
+
+#endif
@@ -0,0 +1,263 @@
+#include "DS7505Store.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t MAGIC = 0x53373044; // "D07S"
+static const uint32_t VERSION = 1;
+
+DS7505Series::DS7505Series()
+{
+  _idx.fd = _raw.fd = _time.fd = -1;
+  _idx.base = _raw.base = _time.base = 0;
+  _idx.size = _raw.size = _time.size = 0;
+}
+
+//extend the file and its mapping to at least size bytes
+bool DS7505Series::grow(Map &m, size_t size)
+{
+  if (size <= m.size)
+    return true;
+
+  size = (size + CHUNK - 1) / CHUNK * CHUNK;
+
+  if (ftruncate(m.fd, size) < 0)
+    return false;
+
+  void *base = m.base
+    ? mremap(m.base, m.size, size, MREMAP_MAYMOVE)
+    : mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, m.fd, 0);
+
+  if (base == MAP_FAILED)
+    return false;
+
+  m.base = (char *) base;
+  m.size = size;
+
+  return true;
+}
+
+static bool openMap(const std::string &path, int &fd, size_t &size)
+{
+  struct stat st;
+
+  if ((fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)) < 0)
+    return false;
+
+  if (fstat(fd, &st) < 0)
+    return false;
+
+  size = st.st_size;
+  return true;
+}
+
+bool DS7505Series::open(const std::string &path)
+{
+  size_t sizes[3];
+  Map *maps[3] = { &_idx, &_raw, &_time };
+  const char *ext[3] = { ".idx", ".raw", ".time" };
+
+  close();
+
+  for (int i = 0; i < 3; i++) {
+    if (!openMap(path + ext[i], maps[i]->fd, sizes[i])) {
+      close();
+      return false;
+    }
+    // map what is on disk, at least one chunk
+    if (!grow(*maps[i], sizes[i] ? sizes[i] : CHUNK)) {
+      close();
+      return false;
+    }
+  }
+
+  Header *h = header();
+  if (sizes[0] == 0) {
+    h->magic = MAGIC;
+    h->version = VERSION;
+    h->block = BLOCK;
+  }
+  else if (h->magic != MAGIC || h->version != VERSION || h->block != BLOCK) {
+    close();
+    errno = EPROTO;
+    return false;
+  }
+
+  return true;
+}
+
+void DS7505Series::close()
+{
+  Map *maps[3] = { &_idx, &_raw, &_time };
+
+  for (int i = 0; i < 3; i++) {
+    if (maps[i]->base)
+      munmap(maps[i]->base, maps[i]->size);
+    if (maps[i]->fd >= 0)
+      ::close(maps[i]->fd);
+    maps[i]->fd = -1;
+    maps[i]->base = 0;
+    maps[i]->size = 0;
+  }
+}
+
+void DS7505Series::sync()
+{
+  Map *maps[3] = { &_idx, &_raw, &_time };
+
+  for (int i = 0; i < 3; i++)
+    if (maps[i]->base)
+      msync(maps[i]->base, maps[i]->size, MS_ASYNC);
+}
+
+uint64_t DS7505Series::size() const
+{
+  return header() ? header()->samples : 0;
+}
+
+uint64_t DS7505Series::blockCount() const
+{
+  return header() ? header()->blocks : 0;
+}
+
+uint64_t DS7505Series::last() const
+{
+  const Header *h = header();
+
+  return h && h->blocks ? blocks()[h->blocks - 1].t1 : 0;
+}
+
+bool DS7505Series::append(uint64_t t, int16_t raw)
+{
+  Header *h = header();
+  Block *b = h->blocks ? &blocks()[h->blocks - 1] : 0;
+  uint64_t n = h->samples;
+
+  if (b && t < b->t1) {
+    errno = EINVAL;
+    return false;
+  }
+
+  // a new block when full or when the offset no longer fits 32 bits
+  if (!b || b->count == BLOCK || t - b->t0 > UINT32_MAX) {
+    if (!grow(_idx, sizeof(Header) + (h->blocks + 1) * sizeof(Block)))
+      return false;
+
+    h = header();
+    b = &blocks()[h->blocks++];
+    b->t0 = t;
+    b->first = n;
+    b->count = 0;
+    b->min = INT16_MAX;
+    b->max = INT16_MIN;
+    b->sum = 0;
+  }
+
+  if (!grow(_raw, (n + 1) * sizeof(int16_t)) || !grow(_time, (n + 1) * sizeof(uint32_t)))
+    return false;
+
+  raws()[n] = raw;
+  times()[n] = (uint32_t) (t - b->t0);
+
+  b->t1 = t;
+  b->count++;
+  if (raw < b->min) b->min = raw;
+  if (raw > b->max) b->max = raw;
+  b->sum += raw;
+
+  h->samples = n + 1;
+
+  return true;
+}
+
+uint64_t DS7505Series::findBlock(uint64_t t) const
+{
+  uint64_t lo = 0, hi = header()->blocks;
+
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    if (blocks()[mid].t1 < t)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+void DS7505Series::clip(const Block &b, uint64_t t0, uint64_t t1, uint64_t &begin, uint64_t &end) const
+{
+  const uint32_t *time = times();
+  uint64_t lo = b.first, hi = b.first + b.count;
+
+  begin = lo;
+  end = hi;
+
+  if (t0 > b.t0) {
+    uint32_t off = (uint32_t) (t0 - b.t0);
+    uint64_t l = lo, h = hi;
+    while (l < h) {
+      uint64_t m = l + (h - l) / 2;
+      if (time[m] < off) l = m + 1; else h = m;
+    }
+    begin = l;
+  }
+
+  if (t1 < b.t1) {
+    uint32_t off = (uint32_t) (t1 - b.t0);
+    uint64_t l = begin, h = hi;
+    while (l < h) {
+      uint64_t m = l + (h - l) / 2;
+      if (time[m] <= off) l = m + 1; else h = m;
+    }
+    end = l;
+  }
+}
+
+DS7505Summary DS7505Series::summary(uint64_t t0, uint64_t t1) const
+{
+  DS7505Summary s;
+  const Header *h = header();
+
+  for (uint64_t i = findBlock(t0); i < h->blocks && blocks()[i].t0 <= t1; i++) {
+    const Block &b = blocks()[i];
+
+    if (t0 <= b.t0 && b.t1 <= t1) {
+      DS7505Summary bs;
+      bs.min = b.min;
+      bs.max = b.max;
+      bs.sum = b.sum;
+      bs.count = b.count;
+      s.add(bs);
+      continue;
+    }
+
+    uint64_t begin, end;
+    clip(b, t0, t1, begin, end);
+    for (uint64_t n = begin; n < end; n++)
+      s.add(raws()[n]);
+  }
+
+  return s;
+}
+
+bool DS7505Store::open(const std::string &dir)
+{
+  if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST)
+    return false;
+
+  _dir = dir;
+  return true;
+}
+
+bool DS7505Store::open(DS7505Series &series, unsigned bus, uint8_t addr) const
+{
+  char name[32];
+
+  snprintf(name, sizeof(name), "/bus%u-0x%02x", bus, addr);
+
+  return series.open(_dir + name);
+}
@@ -0,0 +1,188 @@
+#ifndef DS7505_STORE_H
+#define DS7505_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+//! min/max/sum/count of raw codes
+struct DS7505Summary
+{
+  int16_t min;
+  int16_t max;
+  int64_t sum;
+  uint64_t count;
+
+  DS7505Summary() : min(INT16_MAX), max(INT16_MIN), sum(0), count(0) {};
+
+  void add(int16_t raw)
+  {
+    if (raw < min) min = raw;
+    if (raw > max) max = raw;
+    sum += raw;
+    count++;
+  }
+
+  void add(const DS7505Summary &s)
+  {
+    if (s.min < min) min = s.min;
+    if (s.max > max) max = s.max;
+    sum += s.sum;
+    count += s.count;
+  }
+
+  //! Mean raw code, DS7505::decodeTemp() scale
+  double mean() const { return count ? (double) sum / count : 0; }
+};
+
+//! Append-only history of one sensor, stored as memory-mapped columns
+/*!
+ * Samples (time in us, raw code) are appended in time order and grouped
+ * in blocks of at most BLOCK samples. Three files hold a series:
+ *
+ *   name.raw    int16 raw codes, one per sample
+ *   name.time   uint32 time of each sample, in us from its block start
+ *   name.idx    header, then one entry per block: time span, first
+ *               sample and min/max/sum/count of its codes
+ *
+ * Range queries binary search the index and only touch the columns of
+ * the blocks partially covered by the range: the pages of blocks fully
+ * covered are never read, their summary answers for them.
+ */
+class DS7505Series
+{
+
+public:
+
+  //! Maximum samples per block
+  static const uint32_t BLOCK = 4096;
+
+  //! Bytes a file grows by at a time, remapping it
+  static const size_t CHUNK = 16 << 20;
+
+  DS7505Series();
+
+  ~DS7505Series() { close(); }
+
+  //! Opens or creates a series
+  /*!
+   * \param path The path of the files, without extension
+   * \return true on success, errno is set otherwise
+   */
+  bool open(const std::string &path);
+
+  //! Syncs and unmaps the series
+  void close();
+
+  //! Appends a sample
+  /*!
+   * \param t The time in us, not earlier than the previous sample
+   * \param raw The raw code
+   * \return false, errno set, when \ref t goes back in time (EINVAL, see
+   *   last()) or the files can't grow
+   */
+  bool append(uint64_t t, int16_t raw);
+
+  //! The time of the last sample in us, 0 when there is none
+  uint64_t last() const;
+
+  //! Summary of the samples in [t0, t1]
+  DS7505Summary summary(uint64_t t0, uint64_t t1) const;
+
+  //! Calls f(t, raw) for each sample in [t0, t1]
+  template <typename F>
+  void scan(uint64_t t0, uint64_t t1, F f) const;
+
+  //! The number of samples
+  uint64_t size() const;
+
+  //! The number of blocks
+  uint64_t blockCount() const;
+
+  //! Flushes the mapped pages to disk
+  void sync();
+
+  struct Block {
+    uint64_t t0; // first sample, us
+    uint64_t t1; // last sample, us
+    uint64_t first; // index of the first sample
+    uint32_t count;
+    int16_t min;
+    int16_t max;
+    int64_t sum;
+  };
+
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t block;
+    uint32_t reserved;
+    uint64_t samples;
+    uint64_t blocks;
+  };
+
+private:
+  struct Map {
+    int fd;
+    char *base;
+    size_t size;
+  };
+
+  Map _idx;
+  Map _raw;
+  Map _time;
+
+  Header *header() const { return (Header *) _idx.base; }
+  Block *blocks() const { return (Block *) (_idx.base + sizeof(Header)); }
+  int16_t *raws() const { return (int16_t *) _raw.base; }
+  uint32_t *times() const { return (uint32_t *) _time.base; }
+
+  static bool grow(Map &m, size_t size);
+
+  //! First block that may hold samples at or after t
+  uint64_t findBlock(uint64_t t) const;
+
+  //! Samples [begin, end) of block b within [t0, t1]
+  void clip(const Block &b, uint64_t t0, uint64_t t1, uint64_t &begin, uint64_t &end) const;
+};
+
+template <typename F>
+void DS7505Series::scan(uint64_t t0, uint64_t t1, F f) const
+{
+  const Header *h = header();
+
+  for (uint64_t i = findBlock(t0); i < h->blocks && blocks()[i].t0 <= t1; i++) {
+    const Block &b = blocks()[i];
+    uint64_t begin, end;
+
+    clip(b, t0, t1, begin, end);
+    for (uint64_t s = begin; s < end; s++)
+      f(b.t0 + times()[s], raws()[s]);
+  }
+}
+
+//! Directory of series, one per (bus, address)
+class DS7505Store
+{
+
+public:
+
+  //! Opens (creating it if needed) a store directory
+  /*!
+   * \return false when the directory can't be created
+   */
+  bool open(const std::string &dir);
+
+  //! Opens the series of a sensor
+  /*!
+   * \param series The series to open
+   * \param bus The bus index
+   * \param addr The I2C address
+   */
+  bool open(DS7505Series &series, unsigned bus, uint8_t addr) const;
+
+private:
+  std::string _dir;
+};
+
+#endif
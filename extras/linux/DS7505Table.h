@@ -0,0 +1,203 @@
+#ifndef DS7505_TABLE_H
+#define DS7505_TABLE_H
+
+#include <DS7505.h>
+#include <atomic>
+#include <new>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//! Latest reading of one sensor, updated under a sequence lock
+struct alignas(64) DS7505Entry
+{
+  std::atomic<uint32_t> seq; //!< odd while the entry is being written
+  std::atomic<int16_t> raw; //!< raw code of the last successful read
+  std::atomic<uint8_t> status; //!< DS7505::Status of the last read
+  std::atomic<uint8_t> present; //!< 1 when a sensor answers at this address
+  std::atomic<uint64_t> timestamp; //!< CLOCK_MONOTONIC ns of the last read
+  std::atomic<uint64_t> samples; //!< successful reads so far
+};
+
+//! A consistent copy of a DS7505Entry
+struct DS7505Snapshot
+{
+  uint32_t seq;
+  int16_t raw;
+  uint8_t status;
+  uint8_t present;
+  uint64_t timestamp;
+  uint64_t samples;
+
+  //! Whether the writer never finished the entry, see DS7505Table::read()
+  bool torn() const { return seq & 1; }
+};
+
+//! Table of the latest readings, 8 entries per bus
+/*!
+ * One writer per bus publishes in place, any number of readers take
+ * consistent snapshots without locks nor copies through the writer: a
+ * reader retries while an entry is being written. The table lives in
+ * memory provided by the caller so it can be shared between processes.
+ */
+class DS7505Table
+{
+
+public:
+
+  static const uint32_t MAGIC = 0x35303744; // "D705"
+  static const uint32_t VERSION = 1;
+
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t buses;
+    uint32_t entrySize;
+  };
+
+  //! Bytes needed for a table of \ref buses buses
+  static size_t size(unsigned buses) { return sizeof(DS7505Entry) + buses * 8 * sizeof(DS7505Entry); }
+
+  DS7505Table() : _header(0), _entries(0) {};
+
+  //! Formats \ref memory (size() bytes, 64 byte aligned) as an empty table
+  void create(void *memory, unsigned buses);
+
+  //! Uses a table formatted by create()
+  /*!
+   * \return false when \ref memory doesn't hold a compatible table
+   */
+  bool attach(void *memory);
+
+  //! The number of buses in the table
+  unsigned buses() const { return _header ? _header->buses : 0; }
+
+  //! The entry of a sensor
+  /*!
+   * \param bus The bus index
+   * \param addr The I2C address (0x48 to 0x4F)
+   */
+  DS7505Entry &entry(unsigned bus, uint8_t addr) { return _entries[bus * 8 + (addr & 0x7)]; }
+  const DS7505Entry &entry(unsigned bus, uint8_t addr) const { return _entries[bus * 8 + (addr & 0x7)]; }
+
+  //! Publishes a reading, only the bus writer may call it
+  void publish(unsigned bus, uint8_t addr, int16_t raw, uint8_t status, uint64_t timestamp);
+
+  //! Marks a sensor present or absent, only the bus writer may call it
+  void setPresent(unsigned bus, uint8_t addr, bool present);
+
+  //! Spins of read() on an entry being written before it yields the CPU
+  static const unsigned SPINS = 1000;
+
+  //! Yields of read() on an entry being written before it gives up
+  static const unsigned YIELDS = 10000;
+
+  //! Takes a consistent snapshot of an entry
+  /*!
+   * A writer is only ever a few stores into an entry, unless it died
+   * there: the entry then stays odd for good. Past SPINS, then YIELDS
+   * more tries the snapshot is given up on, torn() and status
+   * DS7505::ST_TIMEOUT, the other fields as they were left.
+   */
+  static DS7505Snapshot read(const DS7505Entry &e);
+
+  DS7505Snapshot read(unsigned bus, uint8_t addr) const { return read(entry(bus, addr)); }
+
+private:
+  Header *_header;
+  DS7505Entry *_entries;
+};
+
+inline void DS7505Table::create(void *memory, unsigned buses)
+{
+  _header = new (memory) Header();
+  _entries = reinterpret_cast<DS7505Entry *>((char *) memory + sizeof(DS7505Entry));
+
+  for (unsigned i = 0; i < buses * 8; i++)
+    new (&_entries[i]) DS7505Entry();
+
+  _header->buses = buses;
+  _header->entrySize = sizeof(DS7505Entry);
+  _header->version = VERSION;
+  std::atomic_thread_fence(std::memory_order_release);
+  _header->magic = MAGIC;
+}
+
+inline bool DS7505Table::attach(void *memory)
+{
+  Header *h = reinterpret_cast<Header *>(memory);
+
+  if (h->magic != MAGIC || h->version != VERSION || h->entrySize != sizeof(DS7505Entry))
+    return false;
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  _header = h;
+  _entries = reinterpret_cast<DS7505Entry *>((char *) memory + sizeof(DS7505Entry));
+
+  return true;
+}
+
+inline void DS7505Table::publish(unsigned bus, uint8_t addr, int16_t raw, uint8_t status,
+                                 uint64_t timestamp)
+{
+  DS7505Entry &e = entry(bus, addr);
+  uint32_t seq = e.seq.load(std::memory_order_relaxed);
+
+  e.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  if (status == 0) {
+    e.raw.store(raw, std::memory_order_relaxed);
+    e.samples.store(e.samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+  e.status.store(status, std::memory_order_relaxed);
+  e.timestamp.store(timestamp, std::memory_order_relaxed);
+
+  e.seq.store(seq + 2, std::memory_order_release);
+}
+
+inline void DS7505Table::setPresent(unsigned bus, uint8_t addr, bool present)
+{
+  DS7505Entry &e = entry(bus, addr);
+  uint32_t seq = e.seq.load(std::memory_order_relaxed);
+
+  e.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  e.present.store(present, std::memory_order_relaxed);
+  e.seq.store(seq + 2, std::memory_order_release);
+}
+
+inline DS7505Snapshot DS7505Table::read(const DS7505Entry &e)
+{
+  DS7505Snapshot s;
+  uint32_t again;
+  unsigned tries = 0;
+
+  do {
+    while ((s.seq = e.seq.load(std::memory_order_acquire)) & 1) {
+      if (++tries > SPINS + YIELDS)
+        break;
+      if (tries > SPINS)
+        sched_yield(); // the writer may be preempted mid-write
+    }
+
+    s.raw = e.raw.load(std::memory_order_relaxed);
+    s.status = e.status.load(std::memory_order_relaxed);
+    s.present = e.present.load(std::memory_order_relaxed);
+    s.timestamp = e.timestamp.load(std::memory_order_relaxed);
+    s.samples = e.samples.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    again = e.seq.load(std::memory_order_relaxed);
+
+    //the writer died in the middle of the entry
+    if (s.seq & 1) {
+      s.status = DS7505::ST_TIMEOUT;
+      break;
+    }
+  } while (again != s.seq);
+
+  return s;
+}
+
+#endif
@@ -0,0 +1,520 @@
+/*
+ * DS7505 polling daemon for Linux gateways
+ *
+ *   g++ -std=c++11 -O2 -pthread -I. -Iextras/host -Iextras/linux extras/linux/ds7505d.cpp \
+ *       DS7505.cpp DS7505Array.cpp extras/host/DS7505Bus.cpp \
+ *       extras/host/DS7505Sim.cpp extras/host/DS7505Linux.cpp \
+ *       extras/linux/DS7505Shm.cpp extras/linux/DS7505Store.cpp -o ds7505d
+ *
+ *   ds7505d [--bench seconds] [--sim count] [--shm name] [--store dir] [bus...]
+ *
+ * A bus is <device>[:mask[:bits]]: an i2c-dev node or "sim", the mask of
+ * the sensors on it (bit i for address 0x48 | i, 0xff by default) and their
+ * resolution (9 to 12 bits, 12 by default). --sim adds that many simulated
+ * buses of eight 12 bit sensors. A simulated bus takes the time of an
+ * i2c-dev adapter at 400 kHz, asleep like a thread blocked in the ioctl:
+ * 20 us per transfer plus 2.5 us per bit.
+ *
+ * Each bus has a worker thread driven by a timerfd that fires at the
+ * conversion period of its sensors, aligned on multiples of that period.
+ * Every expiry sweeps the bus and publishes the readings in place in a
+ * DS7505Table, the worker being the one writer of its entries. The
+ * transfers block, a thread per bus keeps one bus from delaying the
+ * sweeps of the others.
+ * With --shm the table is created in /dev/shm under that name (for
+ * instance --shm /ds7505) so other processes can poll it, see
+ * DS7505ShmTable. With --store every successful reading is also appended,
+ * stamped with the wall clock, to the history of its sensor in that
+ * directory, see DS7505Store. The wall clock is read once at start up
+ * and advanced with CLOCK_MONOTONIC, so a step of the system clock never
+ * sends a history back in time while running. Readings older than the
+ * history (the clock went back between two runs) are not stored; they
+ * are counted as "rejected" in the statistics, the first one of each bus
+ * reported on stderr. The history command answers from rollups
+ * kept per sensor (DS7505Rollup), seeded from the store at start up.
+ *
+ * The main thread waits for SIGINT/SIGTERM and, unless benchmarking, reads
+ * commands on stdin:
+ *
+ *   dump    latest readings as JSON
+ *   stats   worker statistics as JSON
+ *   history min/max/mean of the last minute, hour, day and week as JSON
+ *   quit
+ *
+ * --bench runs for the given time and prints the worker statistics: the
+ * timer lateness (jitter) percentiles and the CPU used.
+ */
+#include <DS7505Array.h>
+#include <DS7505Linux.h>
+#include <DS7505Shm.h>
+#include <DS7505Rollup.h>
+#include <DS7505Sim.h>
+#include <DS7505Store.h>
+#include <algorithm>
+#include <errno.h>
+#include <mutex>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+//simulated sensors behind an i2c-dev adapter: overhead per transfer, bit time per message
+class TimedSimBus : public DS7505SimBus
+{
+
+public:
+
+  TimedSimBus(uint64_t overheadNs, uint64_t bitNs) : _overhead(overheadNs), _bit(bitNs) {};
+
+  virtual uint8_t write(uint8_t addr, const uint8_t *data, uint8_t n)
+  {
+    clock->sleep(_overhead + message(n));
+    return DS7505SimBus::write(addr, data, n);
+  }
+
+  virtual uint8_t read(uint8_t addr, uint8_t *data, uint8_t n)
+  {
+    clock->sleep(_overhead + message(n));
+    return DS7505SimBus::read(addr, data, n);
+  }
+
+private:
+  uint64_t _overhead;
+  uint64_t _bit;
+
+  // start, address and data bytes with their ack bits, stop
+  uint64_t message(uint8_t n) const { return (2 + 9 * (n + 1)) * _bit; }
+};
+
+struct Worker
+{
+  char name[64];
+  DS7505Bus *bus;
+  DS7505SimBus *sim;
+  DS7505Sim devices[8];
+  DS7505Array array;
+  DS7505Series series[8];
+  DS7505Rollup<60, 60, 168, int64_t, uint32_t> rollups[8];
+  unsigned index;
+  int fd;
+  uint64_t period; // ns
+  uint64_t next; // ns, next scheduled expiry
+  std::thread thread;
+  std::mutex lock; // guards what the main thread reads below
+  uint64_t sweeps;
+  uint64_t overruns;
+  uint64_t failures;
+  uint64_t rejected; // readings the store refused
+  std::vector<uint32_t> lateness; // us, one per expiry when benchmarking
+};
+
+static uint64_t now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static std::vector<Worker *> workers;
+static int stopFd; // readable once the workers must stop
+static DS7505ShmTable shm;
+static DS7505Table table;
+static DS7505Store store;
+static bool storing;
+
+//the wall clock at start up, advanced by the monotonic one
+static uint64_t wallUs()
+{
+  static uint64_t base = [] {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000 - now() / 1000;
+  }();
+
+  return base + now() / 1000;
+}
+
+static Worker *addBus(const char *spec)
+{
+  Worker *w = new Worker();
+  char device[64];
+  unsigned mask = 0xFF, bits = 12;
+
+  if (sscanf(spec, "%63[^:]:%i:%u", device, (int *) &mask, &bits) < 1 || bits < 9 || bits > 12) {
+    fprintf(stderr, "%s: bad bus\n", spec);
+    exit(2);
+  }
+
+  snprintf(w->name, sizeof(w->name), "%s", device);
+  if (strcmp(device, "sim") == 0) {
+    w->bus = w->sim = new TimedSimBus(20000, 2500);
+    for (uint8_t i = 0; i < 8; i++) {
+      w->devices[i].setTemp(20.0 + workers.size() + i / 8.0);
+      w->sim->attach(0x48 | i, &w->devices[i]);
+    }
+    snprintf(w->name, sizeof(w->name), "sim%zu", workers.size());
+  }
+  else {
+    DS7505LinuxBus *bus = new DS7505LinuxBus();
+    if (!bus->open(device)) {
+      perror(device);
+      exit(2);
+    }
+    w->bus = bus;
+  }
+
+  w->index = workers.size();
+  DS7505Bus::select(w->bus);
+  if (!w->array.init(mask, (DS7505::Resolution) (bits - 9)))
+    fprintf(stderr, "%s: no sensor answered\n", w->name);
+  w->period = w->array.conversionTimeMs() * 1000000ull;
+
+  for (uint8_t i = 0; storing && i < 8; i++) {
+    if (!(w->array.mask() & 1 << i))
+      continue;
+
+    if (!store.open(w->series[i], w->index, 0x48 | i)) {
+      perror(w->name);
+      exit(1);
+    }
+
+    // the last week, which the rollups cover
+    DS7505Rollup<60, 60, 168, int64_t, uint32_t> &rollup = w->rollups[i];
+    uint64_t t = wallUs();
+    w->series[i].scan(t - 168 * 3600000000ull, t, [&](uint64_t us, int16_t raw) {
+      rollup.add((uint32_t) (us / 1000000), raw);
+    });
+  }
+
+  workers.push_back(w);
+
+  return w;
+}
+
+//first expiry on the next multiple of the period, then every period
+static void arm(Worker *w)
+{
+  struct itimerspec its;
+
+  w->next = (now() / w->period + 1) * w->period;
+  its.it_value.tv_sec = w->next / 1000000000ull;
+  its.it_value.tv_nsec = w->next % 1000000000ull;
+  its.it_interval.tv_sec = w->period / 1000000000ull;
+  its.it_interval.tv_nsec = w->period % 1000000000ull;
+
+  if ((w->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0
+      || timerfd_settime(w->fd, TFD_TIMER_ABSTIME, &its, 0) < 0) {
+    perror("timerfd");
+    exit(1);
+  }
+}
+
+static void sweep(Worker *w, bool bench)
+{
+  uint64_t expirations;
+  int16_t raw[8];
+
+  if (read(w->fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    return;
+
+  uint64_t t = now();
+  uint64_t late = t - w->next;
+  w->next += expirations * w->period;
+
+  uint8_t read = w->array.sweep(raw);
+  uint64_t us = wallUs();
+  std::lock_guard<std::mutex> guard(w->lock);
+
+  if (bench)
+    w->lateness.push_back((uint32_t) (late / 1000));
+  w->overruns += expirations - 1;
+  w->sweeps++;
+
+  for (uint8_t i = 0; i < 8; i++) {
+    if (!(w->array.mask() & 1 << i))
+      continue;
+
+    if (read & 1 << i) {
+      table.publish(w->index, 0x48 | i, raw[i], DS7505::ST_OK, t);
+      w->rollups[i].add((uint32_t) (us / 1000000), raw[i]);
+      if (storing && !w->series[i].append(us, raw[i]) && w->rejected++ == 0)
+        fprintf(stderr, "%s 0x%02x: not stored: %s\n", w->name, 0x48 | i,
+                errno == EINVAL ? "older than its history, the clock went back" : strerror(errno));
+    }
+    else {
+      table.publish(w->index, 0x48 | i, 0, DS7505::ST_ERROR, t);
+      w->failures++;
+    }
+  }
+}
+
+//the worker thread of a bus, until stopFd is readable
+static void work(Worker *w, bool bench)
+{
+  struct pollfd fds[2] = { { w->fd, POLLIN, 0 }, { stopFd, POLLIN, 0 } };
+
+  DS7505Bus::select(w->bus);
+  while (poll(fds, 2, -1) > 0 && !fds[1].revents)
+    sweep(w, bench);
+}
+
+static void dump(FILE *f)
+{
+  bool first = true;
+
+  fprintf(f, "[");
+  for (size_t b = 0; b < workers.size(); b++) {
+    for (uint8_t i = 0; i < 8; i++) {
+      DS7505Snapshot s = table.read(b, 0x48 | i);
+
+      if (!s.present)
+        continue;
+
+      fprintf(f, "%s\n  {\"bus\": \"%s\", \"address\": %u, \"celsius\": %.4f, \"status\": %u, "
+              "\"timestamp_ns\": %llu, \"samples\": %llu}",
+              first ? "" : ",", workers[b]->name, 0x48 | i, DS7505::decodeTemp(s.raw), s.status,
+              (unsigned long long) s.timestamp, (unsigned long long) s.samples);
+      first = false;
+    }
+  }
+  fprintf(f, "\n]\n");
+  fflush(f);
+}
+
+static void history(FILE *f)
+{
+  static const uint32_t WINDOWS[] = { 60, 3600, 86400, 7 * 86400 };
+  static const char *LABELS[] = { "minute", "hour", "day", "week" };
+  uint32_t t = (uint32_t) (wallUs() / 1000000);
+  bool first = true;
+
+  fprintf(f, "[");
+  for (size_t b = 0; b < workers.size(); b++) {
+    for (uint8_t i = 0; i < 8; i++) {
+      if (!(workers[b]->array.mask() & 1 << i))
+        continue;
+
+      std::lock_guard<std::mutex> guard(workers[b]->lock);
+      fprintf(f, "%s\n  {\"bus\": \"%s\", \"address\": %u", first ? "" : ",", workers[b]->name, 0x48 | i);
+      for (unsigned w = 0; w < 4; w++) {
+        DS7505Rollup<60, 60, 168, int64_t, uint32_t>::Bucket s = workers[b]->rollups[i].query(t - WINDOWS[w] + 1, t);
+        if (s.count)
+          fprintf(f, ", \"%s\": {\"min\": %.4f, \"max\": %.4f, \"mean\": %.4f, \"samples\": %u}",
+                  LABELS[w], DS7505::decodeTemp(s.min), DS7505::decodeTemp(s.max),
+                  s.mean() / 256.0, s.count);
+      }
+      fprintf(f, "}");
+      first = false;
+    }
+  }
+  fprintf(f, "\n]\n");
+  fflush(f);
+}
+
+static void stats(FILE *f, double seconds)
+{
+  uint64_t sweeps = 0, overruns = 0, failures = 0, rejected = 0, samples = 0;
+  unsigned sensors = 0;
+  std::vector<uint32_t> lateness;
+  struct rusage ru;
+
+  for (size_t b = 0; b < workers.size(); b++) {
+    std::lock_guard<std::mutex> guard(workers[b]->lock);
+    lateness.insert(lateness.end(), workers[b]->lateness.begin(), workers[b]->lateness.end());
+    sweeps += workers[b]->sweeps;
+    overruns += workers[b]->overruns;
+    failures += workers[b]->failures;
+    rejected += workers[b]->rejected;
+    sensors += __builtin_popcount(workers[b]->array.mask());
+    for (uint8_t i = 0; i < 8; i++)
+      samples += table.read(b, 0x48 | i).samples;
+  }
+
+  std::sort(lateness.begin(), lateness.end());
+  uint32_t p50 = lateness.empty() ? 0 : lateness[lateness.size() / 2];
+  uint32_t p99 = lateness.empty() ? 0 : lateness[lateness.size() * 99 / 100];
+  uint32_t max = lateness.empty() ? 0 : lateness.back();
+
+  getrusage(RUSAGE_SELF, &ru);
+  double cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+
+  fprintf(f, "{\"buses\": %zu, \"sensors\": %u, \"seconds\": %.3f, \"sweeps\": %llu, "
+          "\"samples\": %llu, \"samples_per_s\": %.1f, \"overruns\": %llu, \"failures\": %llu, \"rejected\": %llu, "
+          "\"lateness_us\": {\"p50\": %u, \"p99\": %u, \"max\": %u}, \"cpu_percent\": %.2f}\n",
+          workers.size(), sensors, seconds, (unsigned long long) sweeps,
+          (unsigned long long) samples, samples / seconds, (unsigned long long) overruns,
+          (unsigned long long) failures, (unsigned long long) rejected, p50, p99, max, seconds > 0 ? 100 * cpu / seconds : 0);
+  fflush(f);
+}
+
+//one command line, false on quit
+static bool command(const char *line, double seconds)
+{
+  if (strncmp(line, "quit", 4) == 0)
+    return false;
+  else if (strncmp(line, "dump", 4) == 0)
+    dump(stdout);
+  else if (strncmp(line, "stats", 5) == 0)
+    stats(stdout, seconds);
+  else if (strncmp(line, "history", 7) == 0)
+    history(stdout);
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  double bench = 0;
+  const char *shmName = 0;
+  std::vector<const char *> specs;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+      bench = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--sim") == 0 && i + 1 < argc) {
+      for (int n = atoi(argv[++i]); n > 0; n--)
+        specs.push_back("sim");
+    }
+    else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+      shmName = argv[++i];
+    }
+    else if (strcmp(argv[i], "--store") == 0 && i + 1 < argc) {
+      if (!(storing = store.open(argv[++i]))) {
+        perror(argv[i]);
+        return 1;
+      }
+    }
+    else if (argv[i][0] == '-') {
+      fprintf(stderr, "usage: %s [--bench seconds] [--sim count] [--shm name] [--store dir] [device[:mask[:bits]]...]\n", argv[0]);
+      return 2;
+    }
+    else {
+      specs.push_back(argv[i]);
+    }
+  }
+
+  if (specs.empty()) {
+    fprintf(stderr, "no bus given\n");
+    return 2;
+  }
+
+  if (shmName) {
+    if (!shm.create(shmName, specs.size())) {
+      perror(shmName);
+      return 1;
+    }
+    table = shm.table();
+  }
+  else {
+    table.create(aligned_alloc(64, DS7505Table::size(specs.size())), specs.size());
+  }
+
+  for (size_t i = 0; i < specs.size(); i++) {
+    Worker *w = addBus(specs[i]);
+    for (uint8_t a = 0; a < 8; a++)
+      table.setPresent(w->index, 0x48 | a, w->array.mask() & 1 << a);
+  }
+
+  // the default 50us timer slack would dominate the jitter
+  prctl(PR_SET_TIMERSLACK, 1000ul);
+
+  // blocked before the workers start so that they inherit the mask
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  sigprocmask(SIG_BLOCK, &mask, 0);
+
+  stopFd = eventfd(0, EFD_CLOEXEC);
+  for (size_t i = 0; i < workers.size(); i++) {
+    arm(workers[i]);
+    if (bench)
+      workers[i]->lateness.reserve((size_t) (bench * 1000 / 25 + 1));
+    workers[i]->thread = std::thread(work, workers[i], bench > 0);
+  }
+
+  int ep = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event ev;
+  int sfd = signalfd(-1, &mask, SFD_CLOEXEC);
+  ev.events = EPOLLIN;
+  ev.data.ptr = &sfd;
+  epoll_ctl(ep, EPOLL_CTL_ADD, sfd, &ev);
+
+  int stdinFd = STDIN_FILENO;
+  char input[256];
+  size_t inputLength = 0;
+  if (!bench) {
+    ev.data.ptr = &stdinFd;
+    epoll_ctl(ep, EPOLL_CTL_ADD, stdinFd, &ev);
+  }
+
+  uint64_t start = now();
+  uint64_t end = start + (uint64_t) (bench * 1e9);
+  bool running = true;
+  struct epoll_event events[2];
+
+  while (running) {
+    int timeout = bench ? (int) ((end > now() ? end - now() : 0) / 1000000) : -1;
+    int n = epoll_wait(ep, events, 2, timeout);
+
+    if (n < 0 && errno != EINTR)
+      break;
+
+    for (int i = 0; i < n; i++) {
+      if (events[i].data.ptr == &sfd) {
+        running = false;
+      }
+      else {
+        // every complete line read, stdio would keep the rest buffered out of sight of epoll
+        ssize_t got = read(stdinFd, input + inputLength, sizeof(input) - inputLength);
+        if (got < 0 && (errno == EAGAIN || errno == EINTR))
+          continue;
+        if (got <= 0) {
+          running = false;
+          continue;
+        }
+
+        char *line = input, *eol;
+        inputLength += got;
+        while (running && (eol = (char *) memchr(line, '\n', input + inputLength - line))) {
+          *eol = 0;
+          running = command(line, (now() - start) / 1e9);
+          line = eol + 1;
+        }
+
+        inputLength -= line - input;
+        memmove(input, line, inputLength);
+        if (inputLength == sizeof(input))
+          inputLength = 0; // no command is that long
+      }
+    }
+
+    if (bench && now() >= end)
+      running = false;
+  }
+
+  uint64_t stop = 1;
+  if (write(stopFd, &stop, sizeof(stop)) != sizeof(stop))
+    return 1;
+  for (size_t i = 0; i < workers.size(); i++)
+    workers[i]->thread.join();
+
+  if (bench)
+    stats(stdout, (now() - start) / 1e9);
+
+  return 0;
+}
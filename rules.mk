@@ -11,7 +11,7 @@ CFLAGS_$(d) := $(WIRISH_INCLUDES) $(LIBMAPLE_INCLUDES) -I$(SRCROOT)/libraries/Wi
 # Local rules and targets
 cSRCS_$(d) :=
 
-cppSRCS_$(d) := DS7505.cpp
+cppSRCS_$(d) := DS7505.cpp DS7505Array.cpp DS7505Queue.cpp DS7505Scheduler.cpp DS7505Watch.cpp
 
 cFILES_$(d) := $(cSRCS_$(d):%=$(d)/%)
 cppFILES_$(d) := $(cppSRCS_$(d):%=$(d)/%)
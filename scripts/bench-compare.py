@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""Compares two benchmark JSON files written by extras/bench/driver.
+
+usage: bench-compare.py <baseline.json> <current.json> [threshold%]
+
+Prints the change of every result and exits with 1 when a ns_per_op or
+transactions_per_op grew by more than the threshold (5% by default).
+"""
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {r["name"]: r for r in json.load(f)}
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+
+    base, cur = load(sys.argv[1]), load(sys.argv[2])
+    threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 5.0
+    regressions = 0
+
+    for name in sorted(base.keys() & cur.keys()):
+        for metric in ("ns_per_op", "transactions_per_op"):
+            was, now = base[name][metric], cur[name][metric]
+            if was == 0:
+                continue
+            change = (now / was - 1) * 100
+            flag = ""
+            if change > threshold:
+                flag = "  REGRESSION"
+                regressions += 1
+            print("%-24s %-20s %10.3f -> %10.3f %+7.1f%%%s" % (name, metric, was, now, change, flag))
+
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == "__main__":
+    main()